@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/primitives.h"
+#include "triangle_counting.h"
+
+/*
+ * Approximate Triangle Counting on the DODG, 95% confidence intervals (APPROX_Z):
+ * 1st: edge sampling (DOULION), keep each edge with probability p, a triangle survives with p^3.
+ * 2nd: color-based sparsification, N = 1 / p colors, keep the monochromatic edges, a triangle survives with 1 / N^2.
+ * 3rd: wedge sampling, sample the out-wedges (v, w in N+(u)), each triangle is exactly one closed out-wedge.
+ * 1st and 2nd count the sparsified DODG with the per-edge kernel (CountTriPerEdgeDODG), the variance has the term of
+ * the triangle pairs sharing an edge, estimated from the sampled supports.
+ */
+#define APPROX_Z (1.96)
+#define APPROX_PILOT_EDGES (1024 * 1024)
+#define APPROX_PILOT_MIN_TRI (1000)
+#define APPROX_WEDGE_BATCH (64 * 1024)
+#define APPROX_WEDGE_MIN_CLOSED (100)
+
+enum approx_kind_t {
+    APPROX_EDGE = 0, APPROX_COLOR = 1, APPROX_WEDGE = 2
+};
+
+inline const char *ApproxKindName(approx_kind_t kind) {
+    static const char *names[] = {"edge", "color", "wedge"};
+    return names[kind];
+}
+
+inline approx_kind_t ParseApproxKind(const std::string &name) {
+    for (auto it = APPROX_EDGE; it <= APPROX_WEDGE; it = static_cast<approx_kind_t>(it + 1)) {
+        if (name == ApproxKindName(it)) {
+            return it;
+        }
+    }
+    log_warn("Unknown approximation: %s, use %s", name.c_str(), ApproxKindName(APPROX_EDGE));
+    return APPROX_EDGE;
+}
+
+struct approx_tc_t {
+    double estimate;
+    double ci_lo;
+    double ci_hi;
+    double rate;        // edge sampling probability, 1 / colors, or wedges sampled / total wedges
+    size_t samples;     // edges kept or wedges sampled
+};
+
+inline uint64_t SplitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31u);
+}
+
+// Uniform in [0, 1) from the hash of (seed, key).
+inline double HashUniform(uint64_t seed, uint64_t key) {
+    return (SplitMix64(seed ^ SplitMix64(key)) >> 11u) * (1.0 / (1ull << 53u));
+}
+
+/*
+ * SparsifyDODG: the sub-graph of the edges (u, g.adj[edge_idx]) with keep(u, edge_idx), rows stay sorted.
+ * The caller frees the row_ptrs and the adj of the result.
+ */
+template<typename F>
+graph_t SparsifyDODG(graph_t &g, int max_omp_threads, F keep) {
+    graph_t sparse{.n=g.n, .m=0, .adj=nullptr, .row_ptrs=(row_ptr_t *) malloc(sizeof(row_ptr_t) * (g.n + 1))};
+    vector<size_t> histogram;
+    sparse.row_ptrs[0] = 0;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        InclusivePrefixSumOMP(histogram, sparse.row_ptrs + 1, g.n, [&](size_t u) {
+            row_ptr_t cnt = 0;
+            for (auto edge_idx = g.row_ptrs[u]; edge_idx < g.row_ptrs[u + 1]; edge_idx++) {
+                cnt += keep(u, edge_idx);
+            }
+            return cnt;
+        });
+#pragma omp single
+        {
+            sparse.m = sparse.row_ptrs[g.n];
+            sparse.adj = (int32_t *) malloc(sizeof(int32_t) * max<long>(sparse.m, 1));
+        }
+#pragma omp for schedule(dynamic, 100)
+        for (auto u = 0u; u < g.n; u++) {
+            auto off = sparse.row_ptrs[u];
+            for (auto edge_idx = g.row_ptrs[u]; edge_idx < g.row_ptrs[u + 1]; edge_idx++) {
+                if (keep(u, edge_idx)) {
+                    sparse.adj[off++] = g.adj[edge_idx];
+                }
+            }
+        }
+    }
+    return sparse;
+}
+
+/*
+ * Variance of the estimate T_s / P3: T (1 - P3) / P3 + 2 K (P5 - P3^2) / P3^2,
+ * P3: survival probability of a triangle, P5: of two triangles sharing an edge, K: number of such pairs.
+ */
+inline double SparsifiedRelError(double tc, double pairs, double p3, double p5) {
+    if (tc <= 0) {
+        return numeric_limits<double>::max();
+    }
+    auto var = tc * (1 - p3) / p3 + 2 * pairs * (p5 - p3 * p3) / (p3 * p3);
+    return APPROX_Z * sqrt(max(var, 0.0)) / tc;
+}
+
+// rate: p for the edge sampling, 1 / N for the coloring.
+inline void SurvivalProbabilities(approx_kind_t kind, double rate, double &p3, double &p5) {
+    if (kind == APPROX_EDGE) {
+        p3 = rate * rate * rate;
+        p5 = p3 * rate * rate;
+    } else {
+        p3 = rate * rate;
+        p5 = p3 * rate;
+    }
+}
+
+/*
+ * EstimateTriSparsified: the estimate from the triangles of the sparsified DODG (kept with the rate), the pairs of
+ * triangles sharing an edge from its per-edge support.
+ */
+inline approx_tc_t EstimateTriSparsified(graph_t &sparse, int max_omp_threads, approx_kind_t kind, double rate,
+                                         double &pairs_estimate) {
+    uint32_t *edge_support = nullptr;
+    size_t tc_sampled = sparse.m > 0 ? CountTriPerEdgeDODG(sparse, max_omp_threads, edge_support) : 0;
+    double pairs_sampled = 0;
+#pragma omp parallel for num_threads(max_omp_threads) reduction(+:pairs_sampled)
+    for (long edge_idx = 0; edge_idx < sparse.m; edge_idx++) {
+        double s = edge_support[edge_idx];
+        pairs_sampled += s * (s - 1) / 2;
+    }
+    free(edge_support);
+
+    double p3, p5;
+    SurvivalProbabilities(kind, rate, p3, p5);
+    auto estimate = tc_sampled / p3;
+    pairs_estimate = pairs_sampled / p5;
+    auto half_width = SparsifiedRelError(estimate, pairs_estimate, p3, p5) * estimate;
+    if (tc_sampled == 0) {
+        half_width = numeric_limits<double>::infinity();
+    }
+    log_info("[%s] rate: %.9lf, edges kept: %'zu, sampled triangles: %'zu", ApproxKindName(kind), rate,
+             (size_t) sparse.m, tc_sampled);
+    return approx_tc_t{.estimate=estimate, .ci_lo=max(0.0, estimate - half_width), .ci_hi=estimate + half_width,
+            .rate=rate, .samples=(size_t) sparse.m};
+}
+
+inline approx_tc_t CountTriSparsified(graph_t &g, int max_omp_threads, approx_kind_t kind, double rate,
+                                      uint64_t seed, double &pairs_estimate) {
+    Timer timer;
+    auto num_colors = max<uint64_t>(1, llround(1.0 / rate));
+    auto sparse = kind == APPROX_EDGE ?
+                  SparsifyDODG(g, max_omp_threads, [&](uint32_t, row_ptr_t edge_idx) {
+                      return HashUniform(seed, edge_idx) < rate;
+                  }) :
+                  SparsifyDODG(g, max_omp_threads, [&](uint32_t u, row_ptr_t edge_idx) {
+                      return SplitMix64(seed ^ u) % num_colors == SplitMix64(seed ^ g.adj[edge_idx]) % num_colors;
+                  });
+    auto result = EstimateTriSparsified(sparse, max_omp_threads, kind, rate, pairs_estimate);
+    free(sparse.adj);
+    free(sparse.row_ptrs);
+    log_info("[%s] sparsified count time: %.3lfs", ApproxKindName(kind), timer.elapsed());
+    return result;
+}
+
+/*
+ * ApproxTriSparsified (edge sampling or coloring):
+ * target_error > 0: a pilot run (growing from APPROX_PILOT_EDGES kept edges until APPROX_PILOT_MIN_TRI triangles)
+ * gives T and K, the rate is then solved for the relative half-width of the CI <= target_error.
+ * budget > 0: at most budget edges kept (only the budget if target_error <= 0).
+ */
+inline approx_tc_t ApproxTriSparsified(graph_t &g, int max_omp_threads, approx_kind_t kind, double target_error,
+                                       size_t budget, uint64_t seed) {
+    auto max_rate = budget > 0 ? min(1.0, (double) budget / max<long>(g.m, 1)) : 1.0;
+    auto to_rate = [kind](double rate) {
+        return kind == APPROX_COLOR ? 1.0 / max(1.0, floor(1.0 / rate)) : rate;
+    };
+    double pairs;
+    if (target_error <= 0) {
+        return CountTriSparsified(g, max_omp_threads, kind, to_rate(max_rate), seed, pairs);
+    }
+
+    // Pilot.
+    auto rate = to_rate(min(max_rate, (double) APPROX_PILOT_EDGES / max<long>(g.m, 1)));
+    auto pilot = CountTriSparsified(g, max_omp_threads, kind, rate, seed, pairs);
+    while (pilot.estimate * (kind == APPROX_EDGE ? rate * rate * rate : rate * rate) < APPROX_PILOT_MIN_TRI &&
+           rate < max_rate) {
+        rate = to_rate(min(max_rate, rate * 4));
+        pilot = CountTriSparsified(g, max_omp_threads, kind, rate, seed, pairs);
+    }
+
+    // Bisection on the rate, the relative error decreases with it.
+    double lo = rate, hi = max_rate, p3, p5;
+    SurvivalProbabilities(kind, lo, p3, p5);
+    if (SparsifiedRelError(pilot.estimate, pairs, p3, p5) <= target_error || lo >= hi) {
+        return pilot;
+    }
+    for (auto it = 0; it < 64; it++) {
+        auto mid = (lo + hi) / 2;
+        SurvivalProbabilities(kind, mid, p3, p5);
+        if (SparsifiedRelError(pilot.estimate, pairs, p3, p5) <= target_error) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    log_info("[%s] pilot estimate: %.0lf, sharing-edge pairs: %.0lf, planned rate: %.9lf", ApproxKindName(kind),
+             pilot.estimate, pairs, hi);
+    return CountTriSparsified(g, max_omp_threads, kind, to_rate(hi), seed + 1, pairs);
+}
+
+inline bool HasEdgeDODG(graph_t &g, int32_t v, int32_t w) {
+    return binary_search(g.adj + g.row_ptrs[v], g.adj + g.row_ptrs[v + 1], w) ||
+           binary_search(g.adj + g.row_ptrs[w], g.adj + g.row_ptrs[w + 1], v);
+}
+
+/*
+ * ApproxTriWedgeSampling: batches of APPROX_WEDGE_BATCH samples per thread until the relative half-width of the
+ * binomial CI is <= target_error (with at least APPROX_WEDGE_MIN_CLOSED closed ones), or budget samples.
+ */
+inline approx_tc_t ApproxTriWedgeSampling(graph_t &g, int max_omp_threads, double target_error, size_t budget,
+                                          uint64_t seed) {
+    Timer timer;
+    auto *wedge_prefix = (size_t *) malloc(sizeof(size_t) * max<long>(g.n, 1));
+    vector<size_t> histogram;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        InclusivePrefixSumOMP(histogram, wedge_prefix, g.n, [&g](size_t u) {
+            size_t d = g.row_ptrs[u + 1] - g.row_ptrs[u];
+            return d * (d - (d > 0)) / 2;
+        });
+    }
+    size_t num_wedges = g.n > 0 ? wedge_prefix[g.n - 1] : 0;
+    if (budget == 0) {
+        budget = numeric_limits<size_t>::max();
+    }
+
+    size_t samples = 0, closed = 0;
+    double estimate = 0, half_width = numeric_limits<double>::infinity();
+    while (num_wedges > 0 && samples < budget) {
+        auto batch = min<size_t>(budget - samples, (size_t) APPROX_WEDGE_BATCH * max_omp_threads);
+        size_t batch_closed = 0;
+#pragma omp parallel for num_threads(max_omp_threads) reduction(+:batch_closed)
+        for (size_t i = samples; i < samples + batch; i++) {
+            auto h = SplitMix64(seed ^ SplitMix64(i));
+            auto u = upper_bound(wedge_prefix, wedge_prefix + g.n, h % num_wedges) - wedge_prefix;
+            auto d = g.row_ptrs[u + 1] - g.row_ptrs[u];
+            auto h2 = SplitMix64(h);
+            auto a = h2 % d;
+            auto b = (h2 >> 32u) % (d - 1);
+            b += b >= a;
+            batch_closed += HasEdgeDODG(g, g.adj[g.row_ptrs[u] + a], g.adj[g.row_ptrs[u] + b]);
+        }
+        samples += batch;
+        closed += batch_closed;
+        auto q = (double) closed / samples;
+        estimate = q * num_wedges;
+        half_width = APPROX_Z * sqrt(q * (1 - q) / samples) * num_wedges;
+        if (target_error > 0 && closed >= APPROX_WEDGE_MIN_CLOSED && half_width <= target_error * estimate) {
+            break;
+        }
+    }
+    free(wedge_prefix);
+    log_info("[wedge] out-wedges: %'zu, sampled: %'zu, closed: %'zu, time: %.3lfs", num_wedges, samples, closed,
+             timer.elapsed());
+    return approx_tc_t{.estimate=estimate, .ci_lo=max(0.0, estimate - half_width), .ci_hi=estimate + half_width,
+            .rate=num_wedges > 0 ? (double) samples / num_wedges : 0, .samples=samples};
+}
+
+inline approx_tc_t ApproxTriDODG(graph_t &g, int max_omp_threads, approx_kind_t kind, double target_error,
+                                 size_t budget, uint64_t seed) {
+    Timer timer;
+    auto result = kind == APPROX_WEDGE ? ApproxTriWedgeSampling(g, max_omp_threads, target_error, budget, seed) :
+                  ApproxTriSparsified(g, max_omp_threads, kind, target_error, budget, seed);
+    log_info("[%s] estimate: %.0lf, 95%% CI: [%.0lf, %.0lf], rate: %.9lf, samples: %'zu, time: %.3lfs",
+             ApproxKindName(kind), result.estimate, result.ci_lo, result.ci_hi, result.rate, result.samples,
+             timer.elapsed());
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "triangle_counting.h"
+
+/*
+ * Clustering Coefficients: the wedges of v are d(v) * (d(v) - 1) / 2, with d(v) the undirected degree in deg_lst
+ * (original IDs, from ConvertEdgeListToDODGCSR), the triangles of v from CountTriPerVertexDODG (new IDs).
+ * local_cc (original IDs): triangles(v) / wedges(v), 0 for d(v) < 2.
+ * Returns the global transitivity: 3 * triangles / wedges = sum of triangles(v) / sum of wedges(v).
+ */
+inline double ComputeClusteringDODG(graph_t &g, int max_omp_threads, const uint32_t *deg_lst,
+                                    const vector<int32_t> &old_dict, float *&local_cc, size_t &tc_cnt) {
+    size_t *vertex_tc_cnt = nullptr;
+    tc_cnt = CountTriPerVertexDODG(g, max_omp_threads, vertex_tc_cnt);
+    Timer timer;
+    local_cc = (float *) malloc(sizeof(float) * g.n);
+    double sum_vertex_tc = 0, sum_wedges = 0, sum_local_cc = 0;
+#pragma omp parallel for num_threads(max_omp_threads) schedule(static) \
+reduction(+:sum_vertex_tc, sum_wedges, sum_local_cc)
+    for (auto u = 0u; u < g.n; u++) {
+        auto org_u = old_dict[u];
+        double d = deg_lst[org_u];
+        auto wedges = d * (d - 1) / 2;
+        auto cc = wedges > 0 ? vertex_tc_cnt[u] / wedges : 0;
+        local_cc[org_u] = cc;
+        sum_vertex_tc += vertex_tc_cnt[u];
+        sum_wedges += wedges;
+        sum_local_cc += cc;
+    }
+    free(vertex_tc_cnt);
+    auto transitivity = sum_wedges > 0 ? sum_vertex_tc / sum_wedges : 0;
+    log_info("Clustering Time: %.3lfs, wedges: %.0lf, avg local clustering coefficient: %.6lf", timer.elapsed(),
+             sum_wedges, g.n > 0 ? sum_local_cc / g.n : 0);
+    log_info("Transitivity: %.6lf", transitivity);
+    return transitivity;
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "ips4o/ips4o.hpp"
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/primitives.h"
+#include "util/set_inter_emit_utils.h"
+
+/*
+ * Dynamic Triangle Counting under batches of edge insertions and deletions.
+ * The graph is an undirected CSR in the degree-descending IDs, rows sorted, with slack: the row u is
+ * [row_ptrs[u], row_ptrs[u] + deg[u]) and may grow up to row_ptrs[u + 1]; a batch overflowing a row re-lays out all
+ * the rows with a fresh slack.
+ * A batch (original IDs) is canonicalized (u < v), sorted and deduplicated in parallel (the last update of an edge
+ * wins), the no-ops (inserting an existing edge, deleting a missing one) are dropped.
+ * Delta: the deletions D are counted on G before removing them, the insertions I on (G \ D) + I after adding them.
+ * For e = (u, v) of X in {D, I}, the triangles N(u) & N(v) are attributed to the first edge of X (sorted) in them, so
+ * that a triangle with several edges of X is counted once: delta = |triangles hit by I| - |triangles hit by D|.
+ */
+#define DYN_SLACK_RATIO (4)     // the slack of a row of degree d: d / DYN_SLACK_RATIO + DYN_MIN_SLACK
+#define DYN_MIN_SLACK (4)
+
+enum edge_op_t {
+    EDGE_OP_INSERT = 0, EDGE_OP_DELETE = 1
+};
+
+// A record of the batch file (int32 triples, original IDs).
+struct edge_update_t {
+    int32_t u;
+    int32_t v;
+    int32_t op;
+};
+
+struct dynamic_graph_t {
+    graph_t g;                  // m: the undirected edges, adj: the rows with their slack
+    uint32_t *deg;
+    vector<int32_t> new_dict;   // original -> new IDs, the IDs out of it are new vertices (kept as they are)
+    size_t tc_cnt;
+};
+
+struct batch_result_t {
+    size_t tc_cnt;
+    int64_t delta;
+    size_t num_insertions;      // the effective ones
+    size_t num_deletions;
+};
+
+inline uint64_t DynEdgeKey(uint32_t u, uint32_t v) {
+    return (static_cast<uint64_t>(u) << 32) | v;
+}
+
+inline row_ptr_t DynRowCapacity(row_ptr_t d) {
+    return d + d / DYN_SLACK_RATIO + DYN_MIN_SLACK;
+}
+
+inline bool DynHasEdge(const dynamic_graph_t &dg, int32_t u, int32_t v) {
+    if (dg.deg[u] > dg.deg[v]) {
+        swap(u, v);
+    }
+    auto *row = dg.g.adj + dg.g.row_ptrs[u];
+    return binary_search(row, row + dg.deg[u], v);
+}
+
+inline void FreeDynamicGraph(dynamic_graph_t &dg) {
+    free(dg.g.adj);
+    free(dg.g.row_ptrs);
+    free(dg.deg);
+    dg.g.adj = nullptr;
+    dg.g.row_ptrs = nullptr;
+    dg.deg = nullptr;
+}
+
+/*
+ * RelayoutDynamicGraph: the rows of the n vertices (new ones empty), the capacity of the row u for
+ * deg[u] + extra[u] (extra: nullptr for none) plus the slack.
+ */
+inline void RelayoutDynamicGraph(dynamic_graph_t &dg, uint32_t n, const uint32_t *extra, int max_omp_threads) {
+    Timer timer;
+    auto old_n = static_cast<uint32_t>(dg.g.n);
+    if (n > old_n) {
+        dg.deg = (uint32_t *) realloc(dg.deg, sizeof(uint32_t) * n);
+        memset(dg.deg + old_n, 0, sizeof(uint32_t) * (n - old_n));
+    }
+    auto *row_ptrs = (row_ptr_t *) malloc(sizeof(row_ptr_t) * (n + 1));
+    row_ptrs[0] = 0;
+    int32_t *adj = nullptr;
+    vector<row_ptr_t> histogram;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        InclusivePrefixSumOMP(histogram, row_ptrs + 1, n, [&dg, extra](uint32_t u) {
+            return DynRowCapacity(dg.deg[u] + (extra != nullptr ? extra[u] : 0));
+        });
+#pragma omp single
+        {
+            adj = (int32_t *) malloc(sizeof(int32_t) * row_ptrs[n]);
+        }
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < (dg.g.adj != nullptr ? min(n, old_n) : 0u); u++) {
+            memcpy(adj + row_ptrs[u], dg.g.adj + dg.g.row_ptrs[u], sizeof(int32_t) * dg.deg[u]);
+        }
+    }
+    free(dg.g.adj);
+    free(dg.g.row_ptrs);
+    dg.g.adj = adj;
+    dg.g.row_ptrs = row_ptrs;
+    dg.g.n = n;
+    log_info("Dynamic Relayout Time: %.3lfs, |V|: %u, capacity: %zu", timer.elapsed(), n, row_ptrs[n]);
+}
+
+// The undirected rows with slack from the DODG, tc_cnt: its triangle count.
+inline void BuildDynamicGraph(graph_t &g, const vector<int32_t> &new_dict, size_t tc_cnt, int max_omp_threads,
+                              dynamic_graph_t &dg) {
+    Timer timer;
+    dg.g = graph_t{.n = g.n, .m = static_cast<long>(g.row_ptrs[g.n]), .adj = nullptr, .row_ptrs = nullptr};
+    dg.deg = (uint32_t *) malloc(sizeof(uint32_t) * max<long>(g.n, 1));
+    dg.new_dict = new_dict;
+    dg.tc_cnt = tc_cnt;
+    auto n = static_cast<uint32_t>(g.n);
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(dg.deg, 0, n);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < n; u++) {
+            __sync_fetch_and_add(&dg.deg[u], g.row_ptrs[u + 1] - g.row_ptrs[u]);
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                __sync_fetch_and_add(&dg.deg[g.adj[off]], 1);
+            }
+        }
+    }
+    RelayoutDynamicGraph(dg, n, nullptr, max_omp_threads);
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(dg.deg, 0, n);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < n; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                auto v = g.adj[off];
+                dg.g.adj[dg.g.row_ptrs[u] + __sync_fetch_and_add(&dg.deg[u], 1)] = v;
+                dg.g.adj[dg.g.row_ptrs[v] + __sync_fetch_and_add(&dg.deg[v], 1)] = u;
+            }
+        }
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < n; u++) {
+            sort(dg.g.adj + dg.g.row_ptrs[u], dg.g.adj + dg.g.row_ptrs[u] + dg.deg[u]);
+        }
+    }
+    log_info("Build Dynamic Graph Time: %.3lfs, |E|: %lld, Mem Usage: %d KB", timer.elapsed(), dg.g.m, getValue());
+}
+
+/*
+ * ForEachRowRunOMP: f(u, beg, end) for the runs [beg, end) of the directed edges (sorted keys) out of u,
+ * inside a parallel region.
+ */
+template<typename F>
+void ForEachRowRunOMP(const uint64_t *dir_edges, size_t num, F f) {
+#pragma omp for schedule(dynamic, 1024)
+    for (size_t i = 0; i < num; i++) {
+        auto u = dir_edges[i] >> 32;
+        if (i > 0 && (dir_edges[i - 1] >> 32) == u) {
+            continue;
+        }
+        auto end = i + 1;
+        for (; end < num && (dir_edges[end] >> 32) == u; end++);
+        f(static_cast<uint32_t>(u), i, end);
+    }
+}
+
+// Both directions of the canonical edges, sorted by (src, dst).
+inline uint64_t *DirectDynEdges(const uint64_t *edges, size_t num, int max_omp_threads) {
+    auto *dir_edges = (uint64_t *) malloc(sizeof(uint64_t) * max<size_t>(2 * num, 1));
+#pragma omp parallel for num_threads(max_omp_threads)
+    for (size_t i = 0; i < num; i++) {
+        uint32_t u = edges[i] >> 32, v = edges[i] & UINT32_MAX;
+        dir_edges[2 * i] = edges[i];
+        dir_edges[2 * i + 1] = DynEdgeKey(v, u);
+    }
+    ips4o::parallel::sort(dir_edges, dir_edges + 2 * num);
+    return dir_edges;
+}
+
+// The triangles of the canonical sorted edges, each counted once, by the first of these edges in it.
+inline size_t CountBatchTriDynamic(dynamic_graph_t &dg, const uint64_t *edges, size_t num, int max_omp_threads) {
+    uint32_t max_d = 0;
+#pragma omp parallel for num_threads(max_omp_threads) reduction(max: max_d)
+    for (auto u = 0u; u < dg.g.n; u++) {
+        max_d = max(max_d, dg.deg[u]);
+    }
+    size_t cnt = 0;
+#pragma omp parallel num_threads(max_omp_threads) reduction(+:cnt)
+    {
+        vector<row_ptr_t> out_off_u(max<uint32_t>(max_d, 1)), out_off_v(max<uint32_t>(max_d, 1));
+#pragma omp for schedule(dynamic, 16)
+        for (size_t i = 0; i < num; i++) {
+            uint32_t u = edges[i] >> 32, v = edges[i] & UINT32_MAX;
+            if (dg.deg[u] == 0 || dg.deg[v] == 0) {
+                continue;
+            }
+            auto beg_u = dg.g.row_ptrs[u], beg_v = dg.g.row_ptrs[v];
+            auto num_w = SetInterEmitVecMerge(&dg.g, beg_u, beg_u + dg.deg[u], beg_v, beg_v + dg.deg[v],
+                                              &out_off_u.front(), &out_off_v.front());
+            for (auto j = 0; j < num_w; j++) {
+                uint32_t w = dg.g.adj[out_off_u[j]];
+                if (binary_search(edges, edges + i, DynEdgeKey(min(u, w), max(u, w))) ||
+                    binary_search(edges, edges + i, DynEdgeKey(min(v, w), max(v, w)))) {
+                    continue;
+                }
+                cnt++;
+            }
+        }
+    }
+    return cnt;
+}
+
+/*
+ * ApplyBatchDynamic: applies the batch to dg, returns the new count and the delta.
+ */
+inline batch_result_t ApplyBatchDynamic(dynamic_graph_t &dg, const edge_update_t *updates, size_t num_updates,
+                                        int max_omp_threads) {
+    struct batch_entry_t {
+        uint64_t key;
+        uint32_t idx;
+        int32_t op;
+    };
+    enum entry_state_t {
+        ENTRY_NONE = 0, ENTRY_INSERT = 1, ENTRY_DELETE = 2
+    };
+    Timer timer;
+    auto *entries = (batch_entry_t *) malloc(sizeof(batch_entry_t) * max<size_t>(num_updates, 1));
+    int64_t max_id = dg.g.n - 1;
+    size_t num_invalid = 0;
+    auto dict_size = static_cast<int64_t>(dg.new_dict.size());
+#pragma omp parallel for num_threads(max_omp_threads) reduction(max: max_id) reduction(+:num_invalid)
+    for (size_t i = 0; i < num_updates; i++) {
+        auto u = updates[i].u, v = updates[i].v;
+        auto op = updates[i].op;
+        if (u < 0 || v < 0 || u == v || (op != EDGE_OP_INSERT && op != EDGE_OP_DELETE)) {
+            num_invalid++;
+            entries[i] = batch_entry_t{.key = UINT64_MAX, .idx = static_cast<uint32_t>(i), .op = op};
+            continue;
+        }
+        uint32_t new_u = u < dict_size ? dg.new_dict[u] : u;
+        uint32_t new_v = v < dict_size ? dg.new_dict[v] : v;
+        max_id = max<int64_t>(max_id, max(new_u, new_v));
+        entries[i] = batch_entry_t{.key = DynEdgeKey(min(new_u, new_v), max(new_u, new_v)),
+                .idx = static_cast<uint32_t>(i), .op = op};
+    }
+    ips4o::parallel::sort(entries, entries + num_updates, [](const batch_entry_t &l, const batch_entry_t &r) {
+        return l.key < r.key || (l.key == r.key && l.idx < r.idx);
+    });
+    if (num_invalid > 0) {
+        log_warn("Batch: %zu invalid updates (negative IDs, self-loops, unknown ops) skipped", num_invalid);
+    }
+    if (max_id >= dg.g.n) {
+        RelayoutDynamicGraph(dg, max_id + 1, nullptr, max_omp_threads);
+    }
+    auto *keys = (uint64_t *) malloc(sizeof(uint64_t) * max<size_t>(num_updates, 1));
+    auto *state = (uint8_t *) malloc(sizeof(uint8_t) * max<size_t>(num_updates, 1));
+    auto *ins_edges = (uint64_t *) malloc(sizeof(uint64_t) * max<size_t>(num_updates, 1));
+    auto *del_edges = (uint64_t *) malloc(sizeof(uint64_t) * max<size_t>(num_updates, 1));
+    auto *relative_off = (size_t *) malloc(sizeof(size_t) * max<size_t>(num_updates, 1));
+    size_t num_ins = 0, num_del = 0;
+    vector<size_t> histogram;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        // The last update of an edge, against the graph.
+#pragma omp for
+        for (size_t i = 0; i < num_updates; i++) {
+            auto key = entries[i].key;
+            keys[i] = key;
+            state[i] = ENTRY_NONE;
+            if (key == UINT64_MAX || (i + 1 < num_updates && entries[i + 1].key == key)) {
+                continue;
+            }
+            auto exists = DynHasEdge(dg, key >> 32, key & UINT32_MAX);
+            if (entries[i].op == EDGE_OP_INSERT && !exists) {
+                state[i] = ENTRY_INSERT;
+            } else if (entries[i].op == EDGE_OP_DELETE && exists) {
+                state[i] = ENTRY_DELETE;
+            }
+        }
+        SelectNotFOMP(histogram, ins_edges, keys, relative_off, num_updates,
+                      [state](size_t i) { return state[i] != ENTRY_INSERT; });
+#pragma omp single
+        {
+            num_ins = num_updates - (num_updates > 0 ? relative_off[num_updates - 1] : 0);
+        }
+        SelectNotFOMP(histogram, del_edges, keys, relative_off, num_updates,
+                      [state](size_t i) { return state[i] != ENTRY_DELETE; });
+#pragma omp single
+        {
+            num_del = num_updates - (num_updates > 0 ? relative_off[num_updates - 1] : 0);
+        }
+    }
+    free(entries);
+    free(keys);
+    free(state);
+    free(relative_off);
+    auto prepare_time = timer.elapsed_and_reset();
+
+    // Deletions: counted before removing them.
+    auto lost = CountBatchTriDynamic(dg, del_edges, num_del, max_omp_threads);
+    auto *dir_edges = DirectDynEdges(del_edges, num_del, max_omp_threads);
+#pragma omp parallel num_threads(max_omp_threads)
+    ForEachRowRunOMP(dir_edges, 2 * num_del, [&dg, dir_edges](uint32_t u, size_t beg, size_t end) {
+        auto *row = dg.g.adj + dg.g.row_ptrs[u];
+        uint32_t write = 0;
+        for (auto r = 0u; r < dg.deg[u]; r++) {
+            if (beg < end && static_cast<uint32_t>(row[r]) == (dir_edges[beg] & UINT32_MAX)) {
+                beg++;
+                continue;
+            }
+            row[write++] = row[r];
+        }
+        dg.deg[u] = write;
+    });
+    free(dir_edges);
+    auto del_time = timer.elapsed_and_reset();
+
+    // Insertions: counted after adding them, the rows are merged in place (from their ends).
+    dir_edges = DirectDynEdges(ins_edges, num_ins, max_omp_threads);
+    bool overflow = false;
+#pragma omp parallel num_threads(max_omp_threads) reduction(||: overflow)
+    ForEachRowRunOMP(dir_edges, 2 * num_ins, [&dg, &overflow](uint32_t u, size_t beg, size_t end) {
+        overflow = overflow || dg.g.row_ptrs[u] + dg.deg[u] + (end - beg) > dg.g.row_ptrs[u + 1];
+    });
+    if (overflow) {
+        auto *extra = (uint32_t *) calloc(dg.g.n, sizeof(uint32_t));
+#pragma omp parallel num_threads(max_omp_threads)
+        ForEachRowRunOMP(dir_edges, 2 * num_ins, [extra](uint32_t u, size_t beg, size_t end) {
+            extra[u] = end - beg;
+        });
+        RelayoutDynamicGraph(dg, dg.g.n, extra, max_omp_threads);
+        free(extra);
+    }
+#pragma omp parallel num_threads(max_omp_threads)
+    ForEachRowRunOMP(dir_edges, 2 * num_ins, [&dg, dir_edges](uint32_t u, size_t beg, size_t end) {
+        auto *row = dg.g.adj + dg.g.row_ptrs[u];
+        int64_t r = static_cast<int64_t>(dg.deg[u]) - 1, k = static_cast<int64_t>(end) - 1;
+        auto w = r + static_cast<int64_t>(end - beg);
+        for (; k >= static_cast<int64_t>(beg); w--) {
+            int32_t v = dir_edges[k] & UINT32_MAX;
+            if (r >= 0 && row[r] > v) {
+                row[w] = row[r--];
+            } else {
+                row[w] = v;
+                k--;
+            }
+        }
+        dg.deg[u] += end - beg;
+    });
+    free(dir_edges);
+    auto gained = CountBatchTriDynamic(dg, ins_edges, num_ins, max_omp_threads);
+    auto ins_time = timer.elapsed();
+    free(ins_edges);
+    free(del_edges);
+
+    dg.g.m += num_ins - num_del;
+    dg.tc_cnt = dg.tc_cnt + gained - lost;
+    auto delta = static_cast<int64_t>(gained) - static_cast<int64_t>(lost);
+    log_info("Batch: %zu updates, %zu insertions, %zu deletions, |E|: %lld", num_updates, num_ins, num_del, dg.g.m);
+    log_info("Batch Time, sort and dedup: %.3lfs, deletions: %.3lfs, insertions: %.3lfs%s", prepare_time, del_time,
+             ins_time, overflow ? " (relayout)" : "");
+    log_info("Triangle Cnt: %'zu (delta: %+lld)", dg.tc_cnt, delta);
+    return batch_result_t{.tc_cnt = dg.tc_cnt, .delta = delta, .num_insertions = num_ins, .num_deletions = num_del};
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/set_inter_cnt_utils.h"
+#include "util/set_inter_emit_utils.h"
+
+/*
+ * k-Clique Counting on the DODG (kClist-style): each k-clique is found once from its source u.
+ * Level 2: the subgraph induced by N+(u) in local IDs (the positions in N+(u)), the row of the i-th out-neighbor v is
+ * N+(u) & N+(v) (emitted by the SIMD intersection).
+ * Level l in [3, k): for w in the candidates C of the l-th vertex, C & N(w) are the candidates of the next level,
+ * written to the per-thread stack of the level, the last level only counts them.
+ * The local rows and the stacks are in one buffer, so that the set intersections run on a graph_t view of it.
+ * Hubs (d+(u) >= KCLIQUE_HUB_DEG) are processed one by one by all the threads, split over their out-edges.
+ */
+#define KCLIQUE_HUB_DEG (1024)
+// The int32 slack after the local rows and the stacks (one AVX-512 vector), a guard for the SIMD intersections.
+#define KCLIQUE_SIMD_PAD (16)
+
+struct kclique_ctx_t {
+    graph_t view;               // adj: the local rows, followed by the stacks
+    row_ptr_t *row_ptrs;        // the local rows, in view.adj
+    row_ptr_t stack_off;        // the stack of level l (l in [4, k)) at stack_off + (l - 4) * du
+    row_ptr_t du;
+    row_ptr_t *out_off_c;
+    row_ptr_t *out_off_w;
+    int k;
+    double *level_time;
+    size_t *level_inters;
+};
+
+// The cliques extending the l-1 vertices so far with the candidates C = [c_beg, c_end) of view.adj.
+inline size_t CountKCliquesLevel(kclique_ctx_t &ctx, row_ptr_t c_beg, row_ptr_t c_end, int l) {
+    auto size = c_end - c_beg;
+    if (l == ctx.k) {
+        return size;
+    }
+    if (size < static_cast<row_ptr_t>(ctx.k - l + 1)) {
+        return 0;
+    }
+    Timer timer;
+    size_t cnt = 0;
+    auto next_beg = ctx.stack_off + (l + 1 - 4) * ctx.du;
+    for (auto c = c_beg; c < c_end; c++) {
+        auto w = ctx.view.adj[c];
+        auto w_beg = ctx.row_ptrs[w], w_end = ctx.row_ptrs[w + 1];
+        if (w_end - w_beg < static_cast<row_ptr_t>(ctx.k - l)) {
+            continue;
+        }
+        ctx.level_inters[l]++;
+        if (l == ctx.k - 1) {
+            cnt += SetInterCntVecMerge(&ctx.view, c_beg, c_end, w_beg, w_end);
+        } else {
+            auto num = SetInterEmitVecMerge(&ctx.view, c_beg, c_end, w_beg, w_end, ctx.out_off_c, ctx.out_off_w);
+            for (auto j = 0; j < num; j++) {
+                ctx.view.adj[next_beg + j] = ctx.view.adj[ctx.out_off_c[j]];
+            }
+            cnt += CountKCliquesLevel(ctx, next_beg, next_beg + num, l + 1);
+        }
+    }
+    ctx.level_time[l] += timer.elapsed();
+    return cnt;
+}
+
+inline size_t CountKCliquesDODG(graph_t &g, int max_omp_threads, int k) {
+    Timer timer;
+    if (k < 3) {
+        log_warn("k-clique: k = %d < 3, use 3", k);
+        k = 3;
+    }
+    int64_t max_d = 0;
+    vector<uint32_t> hubs;
+#pragma omp parallel for num_threads(max_omp_threads) reduction(max: max_d)
+    for (auto u = 0u; u < g.n; u++) {
+        max_d = max<int64_t>(max_d, g.row_ptrs[u + 1] - g.row_ptrs[u]);
+    }
+    for (auto u = 0u; u < g.n; u++) {
+        if (g.row_ptrs[u + 1] - g.row_ptrs[u] >= KCLIQUE_HUB_DEG) {
+            hubs.emplace_back(u);
+        }
+    }
+    // Level l in [4, k) has a stack.
+    int num_stacks = max(k - 4, 0);
+    // Level 2: the local rows, inclusive of each level l: level_time[l], exclusive: minus level_time[l + 1].
+    vector<double> level_time(k + 1, 0);
+    vector<size_t> level_inters(k + 1, 0);
+    size_t clique_cnt = 0;
+
+    // Hubs: shared local rows, followed by the stacks of every thread.
+    vector<int32_t> hub_buf;
+    vector<row_ptr_t> hub_row_ptrs;
+#pragma omp parallel num_threads(max_omp_threads) reduction(+:clique_cnt)
+    {
+        auto tid = omp_get_thread_num();
+        auto num_threads = omp_get_num_threads();
+        vector<double> local_level_time(k + 1, 0);
+        vector<size_t> local_level_inters(k + 1, 0);
+        vector<row_ptr_t> out_off_c(max<int64_t>(max_d, 1)), out_off_w(max<int64_t>(max_d, 1));
+        vector<int32_t> buf(KCLIQUE_SIMD_PAD);
+        vector<row_ptr_t> local_row_ptrs;
+        kclique_ctx_t ctx{.view = graph_t{.n = 0, .m = 0, .adj = nullptr, .row_ptrs = nullptr}, .row_ptrs = nullptr,
+                .stack_off = 0, .du = 0, .out_off_c = &out_off_c.front(), .out_off_w = &out_off_w.front(), .k = k,
+                .level_time = &local_level_time.front(), .level_inters = &local_level_inters.front()};
+        // The local row of the i-th out-neighbor of u, at dst.
+        auto emit_local_row = [&](uint32_t u, row_ptr_t i, int32_t *dst) {
+            auto v = g.adj[g.row_ptrs[u] + i];
+            if (g.row_ptrs[v] == g.row_ptrs[v + 1]) {
+                return 0;
+            }
+            auto num = SetInterEmitVecMerge(&g, g.row_ptrs[u], g.row_ptrs[u + 1], g.row_ptrs[v], g.row_ptrs[v + 1],
+                                            &out_off_c.front(), &out_off_w.front());
+            for (auto j = 0; j < num; j++) {
+                dst[j] = out_off_c[j] - g.row_ptrs[u];
+            }
+            return num;
+        };
+
+        for (auto u: hubs) {
+            Timer level_timer;
+            row_ptr_t du = g.row_ptrs[u + 1] - g.row_ptrs[u];
+#pragma omp single
+            {
+                hub_row_ptrs.assign(du + 1, 0);
+            }
+#pragma omp for schedule(dynamic, 16)
+            for (row_ptr_t i = 0; i < du; i++) {
+                auto v = g.adj[g.row_ptrs[u] + i];
+                hub_row_ptrs[i + 1] = g.row_ptrs[v] == g.row_ptrs[v + 1] ? 0 :
+                                      SetInterCntVecMerge(&g, g.row_ptrs[u], g.row_ptrs[u + 1], g.row_ptrs[v],
+                                                          g.row_ptrs[v + 1]);
+            }
+#pragma omp single
+            {
+                for (row_ptr_t i = 0; i < du; i++) {
+                    hub_row_ptrs[i + 1] += hub_row_ptrs[i];
+                }
+                hub_buf.resize(hub_row_ptrs[du] + num_threads * num_stacks * du + KCLIQUE_SIMD_PAD);
+            }
+#pragma omp for schedule(dynamic, 16)
+            for (row_ptr_t i = 0; i < du; i++) {
+                emit_local_row(u, i, &hub_buf[hub_row_ptrs[i]]);
+            }
+            local_level_time[2] += level_timer.elapsed();
+            ctx.view.adj = hub_buf.data();
+            ctx.row_ptrs = &hub_row_ptrs.front();
+            ctx.stack_off = hub_row_ptrs[du] + tid * num_stacks * du;
+            ctx.du = du;
+#pragma omp for schedule(dynamic, 1)
+            for (row_ptr_t i = 0; i < du; i++) {
+                clique_cnt += CountKCliquesLevel(ctx, hub_row_ptrs[i], hub_row_ptrs[i + 1], 3);
+            }
+        }
+
+#pragma omp for schedule(dynamic, 100) nowait
+        for (auto u = 0u; u < g.n; u++) {
+            row_ptr_t du = g.row_ptrs[u + 1] - g.row_ptrs[u];
+            if (du < static_cast<row_ptr_t>(k - 1) || du >= KCLIQUE_HUB_DEG) {
+                continue;
+            }
+            Timer level_timer;
+            local_row_ptrs.resize(du + 1);
+            local_row_ptrs[0] = 0;
+            for (row_ptr_t i = 0; i < du; i++) {
+                auto v = g.adj[g.row_ptrs[u] + i];
+                auto dv = g.row_ptrs[v + 1] - g.row_ptrs[v];
+                if (buf.size() < local_row_ptrs[i] + min(du, dv) + KCLIQUE_SIMD_PAD) {
+                    buf.resize(2 * (local_row_ptrs[i] + min(du, dv)) + KCLIQUE_SIMD_PAD);
+                }
+                local_row_ptrs[i + 1] = local_row_ptrs[i] + emit_local_row(u, i, buf.data() + local_row_ptrs[i]);
+            }
+            if (buf.size() < local_row_ptrs[du] + num_stacks * du + KCLIQUE_SIMD_PAD) {
+                buf.resize(local_row_ptrs[du] + num_stacks * du + KCLIQUE_SIMD_PAD);
+            }
+            local_level_time[2] += level_timer.elapsed();
+            ctx.view.adj = buf.data();
+            ctx.row_ptrs = &local_row_ptrs.front();
+            ctx.stack_off = local_row_ptrs[du];
+            ctx.du = du;
+            for (row_ptr_t i = 0; i < du; i++) {
+                clique_cnt += CountKCliquesLevel(ctx, local_row_ptrs[i], local_row_ptrs[i + 1], 3);
+            }
+        }
+#pragma omp critical
+        for (auto l = 0; l <= k; l++) {
+            level_time[l] += local_level_time[l];
+            level_inters[l] += local_level_inters[l];
+        }
+    }
+    log_info("k-Clique (k = %d), max d: %lld, hubs: %zu", k, max_d, hubs.size());
+    log_info("Level 2 (local rows), time (all threads): %.3lfs", level_time[2]);
+    for (auto l = 3; l < k; l++) {
+        log_info("Level %d, time (all threads, exclusive): %.3lfs, intersections: %'zu", l,
+                 level_time[l] - (l + 1 < k ? level_time[l + 1] : 0), level_inters[l]);
+    }
+    log_info("k-Clique Counting Time: %.3lfs, Mem Usage: %d KB", timer.elapsed(), getValue());
+    log_info("%d-Clique Cnt: %'zu", k, clique_cnt);
+    return clique_cnt;
+}
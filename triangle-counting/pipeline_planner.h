@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "util/log.h"
+#include "util/util.h"
+#include "util/mem_info.h"
+
+/*
+ * Pipeline Selection: the projected peak (bytes) of each phase of each pre-processing pipeline, from the number of
+ * edge records E (an upper bound of the edges) and of vertices V, against the effective memory limit.
+ * in-memory: load and radix-sort the edge list (8E and the buffer, 8E; no sort with sort_free), the DODG scatter
+ * with the edge list kept in memory (8E + 4E).
+ * spill: load and sort in place (8E), the edge list is moved to <spill_dir>/tmp_el.bin before the scatter (evictable,
+ * 4E).
+ * external: runs of the budget (pre_processing_external.h), the scatter holds the adj only (4E).
+ * Common: the vertex arrays of the conversion (24V), the reordering (the adj and its copy, 8E), the counting (4E and
+ * the per-thread bitmaps, V / 8 each).
+ * The first pipeline whose peak fits in PIPELINE_SAFE_RATIO of the limit is selected, the external one otherwise,
+ * with the budget of what is left after the vertex arrays.
+ */
+#define PIPELINE_SAFE_RATIO (0.85)
+#define PIPELINE_MIN_EXT_BUDGET (64ull * 1024 * 1024)
+
+enum pipeline_mode_t {
+    PIPELINE_IN_MEMORY = 0, PIPELINE_SPILL = 1, PIPELINE_EXTERNAL = 2
+};
+
+enum pipeline_phase_t {
+    PHASE_LOAD = 0, PHASE_CONVERT = 1, PHASE_REORDER = 2, PHASE_COUNT = 3, PHASE_NUM = 4
+};
+
+inline const char *PipelineModeName(pipeline_mode_t mode) {
+    static const char *names[] = {"in-memory", "spill", "external"};
+    return names[mode];
+}
+
+inline const char *PipelinePhaseName(pipeline_phase_t phase) {
+    static const char *names[] = {"load", "convert", "reorder", "count"};
+    return names[phase];
+}
+
+inline pipeline_mode_t ParsePipelineMode(const std::string &name) {
+    for (auto it = PIPELINE_IN_MEMORY; it <= PIPELINE_EXTERNAL; it = static_cast<pipeline_mode_t>(it + 1)) {
+        if (name == PipelineModeName(it)) {
+            return it;
+        }
+    }
+    log_warn("Unknown pipeline: %s, use %s", name.c_str(), PipelineModeName(PIPELINE_SPILL));
+    return PIPELINE_SPILL;
+}
+
+struct pipeline_plan_t {
+    pipeline_mode_t mode;
+    size_t mem_limit;           // 0: unknown
+    size_t peak;                // the projected peak of the mode
+    size_t ext_budget;          // the bytes of edges in memory of the external mode
+    size_t phase_peaks[PIPELINE_EXTERNAL + 1][PHASE_NUM];
+};
+
+/*
+ * The max vertex ID in num_samples chunks of sample_size bytes spread over the edge file, the number of vertices
+ * is estimated as its + 1 (exact for the usual files whose last chunk has the largest IDs, a lower bound otherwise).
+ */
+inline uint32_t SampleMaxVertexId(const char *file_name, size_t num_samples, size_t sample_size) {
+    auto file_fd = open(file_name, O_RDONLY);
+    if (file_fd < 0) {
+        return 0;
+    }
+    size_t size = file_size(file_name);
+    uint32_t max_id = 0;
+    vector<uint32_t> buf(sample_size / sizeof(uint32_t));
+    for (size_t i = 0; i < num_samples; i++) {
+        size_t pos = (size - min(size, sample_size)) / max<size_t>(num_samples - 1, 1) * i;
+        pos -= pos % (2 * sizeof(uint32_t));
+        auto ret = pread(file_fd, &buf.front(), sample_size, pos);
+        for (ssize_t j = 0; j < ret / static_cast<ssize_t>(sizeof(uint32_t)); j++) {
+            max_id = max(max_id, buf[j]);
+        }
+    }
+    close(file_fd);
+    return max_id;
+}
+
+inline pipeline_plan_t PlanPipeline(size_t num_records, size_t num_vertices, size_t mem_limit, int max_omp_threads,
+                                    bool sort_free = false) {
+    size_t E = num_records, V = num_vertices;
+    size_t vertex_bytes = 24 * V;
+    pipeline_plan_t plan{.mode = PIPELINE_SPILL, .mem_limit = mem_limit, .peak = 0, .ext_budget = 0};
+    auto safe_limit = static_cast<size_t>(mem_limit * PIPELINE_SAFE_RATIO);
+    plan.ext_budget = max<size_t>(safe_limit > vertex_bytes ? safe_limit - vertex_bytes : 0,
+                                  PIPELINE_MIN_EXT_BUDGET);
+    for (auto mode = PIPELINE_IN_MEMORY; mode <= PIPELINE_EXTERNAL; mode = static_cast<pipeline_mode_t>(mode + 1)) {
+        auto *peaks = plan.phase_peaks[mode];
+        peaks[PHASE_LOAD] = mode == PIPELINE_EXTERNAL ? min(plan.ext_budget, 8 * E) :
+                            (mode == PIPELINE_IN_MEMORY && !sort_free ? 16 * E : 8 * E);
+        peaks[PHASE_CONVERT] = vertex_bytes + (mode == PIPELINE_IN_MEMORY ? 12 * E : 4 * E);
+        peaks[PHASE_REORDER] = vertex_bytes + 8 * E;
+        peaks[PHASE_COUNT] = 16 * V + 4 * E + max_omp_threads * V / 8;
+    }
+    auto mode_peak = [&plan](pipeline_mode_t mode) {
+        return *max_element(plan.phase_peaks[mode], plan.phase_peaks[mode] + PHASE_NUM);
+    };
+    // An unknown limit keeps the former default (spill).
+    plan.mode = mem_limit == 0 ? PIPELINE_SPILL : PIPELINE_EXTERNAL;
+    for (auto mode = PIPELINE_IN_MEMORY; mem_limit > 0 && mode < PIPELINE_EXTERNAL;
+         mode = static_cast<pipeline_mode_t>(mode + 1)) {
+        if (mode_peak(mode) <= safe_limit) {
+            plan.mode = mode;
+            break;
+        }
+    }
+    plan.peak = mode_peak(plan.mode);
+    return plan;
+}
+
+inline void LogPipelinePlan(const pipeline_plan_t &plan, const char *limit_source, bool forced) {
+    for (auto mode = PIPELINE_IN_MEMORY; mode <= PIPELINE_EXTERNAL; mode = static_cast<pipeline_mode_t>(mode + 1)) {
+        auto *peaks = plan.phase_peaks[mode];
+        log_info("Pipeline %s, projected peak (MB), %s: %zu, %s: %zu, %s: %zu, %s: %zu", PipelineModeName(mode),
+                 PipelinePhaseName(PHASE_LOAD), peaks[PHASE_LOAD] >> 20u, PipelinePhaseName(PHASE_CONVERT),
+                 peaks[PHASE_CONVERT] >> 20u, PipelinePhaseName(PHASE_REORDER), peaks[PHASE_REORDER] >> 20u,
+                 PipelinePhaseName(PHASE_COUNT), peaks[PHASE_COUNT] >> 20u);
+    }
+    log_info("Pipeline: %s (%s), projected peak: %zu MB, memory limit: %zu MB (%s)%s", PipelineModeName(plan.mode),
+             forced ? "forced" : "auto", plan.peak >> 20u, plan.mem_limit >> 20u, limit_source,
+             plan.mode == PIPELINE_EXTERNAL ? (", external budget: " + to_string(plan.ext_budget >> 20u) +
+                                               " MB").c_str() : "");
+    if (plan.mem_limit > 0 && plan.peak > plan.mem_limit) {
+        log_warn("Pipeline %s: the projected peak %zu MB exceeds the memory limit %zu MB",
+                 PipelineModeName(plan.mode), plan.peak >> 20u, plan.mem_limit >> 20u);
+    }
+}
+
+/*
+ * The spill directory: spill_dir if writable, else $TMPDIR or /tmp (the first writable one, logged);
+ * empty if none is.
+ */
+inline string ResolveSpillDir(const string &spill_dir) {
+    if (access(spill_dir.c_str(), W_OK) == 0) {
+        return spill_dir;
+    }
+    auto *tmp_dir = getenv("TMPDIR");
+    for (const string &dir: {string(tmp_dir != nullptr ? tmp_dir : ""), string("/tmp")}) {
+        if (!dir.empty() && access(dir.c_str(), W_OK) == 0) {
+            log_warn("Spill directory %s is not writable, use %s", spill_dir.c_str(), dir.c_str());
+            return dir;
+        }
+    }
+    log_warn("Spill directory %s is not writable, and neither is $TMPDIR nor /tmp", spill_dir.c_str());
+    return "";
+}
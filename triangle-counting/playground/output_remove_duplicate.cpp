@@ -2,6 +2,7 @@
 // Created by yche on 11/23/19.
 //
 
+#include <array>
 #include <cassert>
 #include <malloc.h>
 
@@ -53,6 +53,30 @@ int main(int argc, char *argv[]) {
         }
         log_info("Load File Time: %.9lfs", global_timer.elapsed());
 
+        // Parallel LSD Radix Sort of the packed keys (u << bits | v), as the baseline of ips4o below.
+        Timer radix_timer;
+        int32_t max_id = 0;
+#pragma omp parallel for reduction(max: max_id)
+        for (size_t i = 0; i < num_edges; i++) {
+            max_id = max(max_id, max(edge_lst[i].first, edge_lst[i].second));
+        }
+        int bits = max_id == 0 ? 1 : 32 - __builtin_clz(max_id);
+        auto *keys = (uint64_t *) malloc(sizeof(uint64_t) * num_edges);
+        auto *radix_buf = (uint64_t *) malloc(sizeof(uint64_t) * num_edges);
+#pragma omp parallel for
+        for (size_t i = 0; i < num_edges; i++) {
+            keys[i] = (static_cast<uint64_t>(edge_lst[i].first) << bits) | edge_lst[i].second;
+        }
+        log_info("Pack Time: %.9lfs", radix_timer.elapsed());
+        Timer radix_sort_timer;
+        {
+            vector<size_t> histogram;
+#pragma omp parallel
+            RadixSortOMP(histogram, keys, radix_buf, num_edges, 2 * bits);
+        }
+        log_info("Radix Sort Time: %.9lfs (%d bits)", radix_sort_timer.elapsed(), 2 * bits);
+        free(radix_buf);
+
         // Parallel Sort Globally.
         Timer sort_timer;
         ips4o::parallel::sort(edge_lst, edge_lst + num_edges, [](Edge l, Edge r) {
@@ -62,6 +86,13 @@ int main(int argc, char *argv[]) {
             return l.first < r.first;
         });
         log_info("Sort Time: %.9lfs", sort_timer.elapsed());
+        size_t num_mismatches = 0;
+#pragma omp parallel for reduction(+:num_mismatches)
+        for (size_t i = 0; i < num_edges; i++) {
+            num_mismatches += keys[i] != ((static_cast<uint64_t>(edge_lst[i].first) << bits) | edge_lst[i].second);
+        }
+        log_info("Radix vs ips4o, Mismatches: %zu", num_mismatches);
+        free(keys);
 
         // Verification.
         int32_t max_vid = 0;
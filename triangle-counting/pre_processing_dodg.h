@@ -19,10 +19,14 @@ void ConvertEdgeListToDODGCSR(OFF num_edges, pair<T, T> *&edge_lst,
             });
 }
 
+/*
+ * spill_path: the sorted edge list is moved to this file (mmap, edge_lst then has to be munmap-ed by the caller),
+ * so that its pages can be evicted during the scatter; nullptr: it stays in memory (malloc).
+ */
 template<typename T, typename F, typename OFF>
 void ConvertEdgeListToDODGCSR(OFF num_edges, pair<T, T> *&edge_lst,
                               uint32_t num_vertices, uint32_t *&deg_lst, OFF *&off, int32_t *&adj_lst,
-                              int max_omp_threads, F f) {
+                              int max_omp_threads, F f, const char *spill_path = "tmp_el.bin") {
     Timer convert_timer;
     deg_lst = (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
     auto *dodg_deg_lst = (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
@@ -30,14 +34,17 @@ void ConvertEdgeListToDODGCSR(OFF num_edges, pair<T, T> *&edge_lst,
     auto cur_write_off = (OFF *) malloc(sizeof(OFF) * (num_vertices + 1));
     vector<row_ptr_t> histogram;
 
-    auto io_future = std::async(std::launch::async, [=]() {
-        auto tmp_file_fd = open("tmp_el.bin", O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-        size_t size = num_edges * sizeof(int32_t) * 2;
-        ftruncate(tmp_file_fd, size);
-        auto write_buf = (pair<T, T> *) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_file_fd, 0);
-        memcpy(write_buf, edge_lst, size);
-        return write_buf;
-    });
+    std::future<pair<T, T> *> io_future;
+    if (spill_path != nullptr) {
+        io_future = std::async(std::launch::async, [=]() {
+            auto tmp_file_fd = open(spill_path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+            size_t size = num_edges * sizeof(int32_t) * 2;
+            ftruncate(tmp_file_fd, size);
+            auto write_buf = (pair<T, T> *) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_file_fd, 0);
+            memcpy(write_buf, edge_lst, size);
+            return write_buf;
+        });
+    }
 #pragma omp parallel num_threads(max_omp_threads)
     {
         MemSetOMP(deg_lst, 0, num_vertices + 1);
@@ -77,13 +84,15 @@ void ConvertEdgeListToDODGCSR(OFF num_edges, pair<T, T> *&edge_lst,
 #pragma omp single
         {
             log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
-            auto tmp = edge_lst;
-            edge_lst = io_future.get();
-            log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
+            if (spill_path != nullptr) {
+                auto tmp = edge_lst;
+                edge_lst = io_future.get();
+                log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
 
-            size_t size = num_edges * sizeof(int32_t) * 2;
-            free(tmp);
-            madvise(edge_lst, size, MADV_SEQUENTIAL);
+                size_t size = num_edges * sizeof(int32_t) * 2;
+                free(tmp);
+                madvise(edge_lst, size, MADV_SEQUENTIAL);
+            }
 
             if (adj_lst == nullptr) {
                 log_info("Allocate Inside (adj_lst)...");
@@ -111,6 +120,120 @@ void ConvertEdgeListToDODGCSR(OFF num_edges, pair<T, T> *&edge_lst,
     log_info("[%s]: Total Conversion Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
 }
 
+/*
+ * ConvertEdgeListToDODGCSRSortFree: the DODG CSR from the unsorted edge list (with the self-loops and multi-edges),
+ * without the global sort.
+ * 1st: the degrees with the multi-edges, each edge oriented by RankLT on them (a total order, hence still a DAG; the
+ * copies of a multi-edge land in the same row) and scattered to its row.
+ * 2nd: each row (short after the orientation) sorted and deduplicated, the offsets compacted to the new row sizes.
+ * 3rd: deg_lst recomputed from the rows, i.e., the degrees without the multi-edges, as the sorted path.
+ * edge_lst: freed (nullptr) after the scatter, adj_lst: allocated inside.
+ * edge_deg_lst: the degrees with the multi-edges (without the self-loops, at least num_vertices + 1 entries) if
+ * already counted, e.g., by the loader, taken over as deg_lst; nullptr: counted here.
+ */
+template<typename T, typename OFF>
+void ConvertEdgeListToDODGCSRSortFree(OFF num_edges, pair<T, T> *&edge_lst,
+                                      uint32_t num_vertices, uint32_t *&deg_lst, OFF *&off, int32_t *&adj_lst,
+                                      int max_omp_threads, uint32_t *edge_deg_lst = nullptr) {
+    Timer convert_timer;
+    deg_lst = edge_deg_lst != nullptr ? edge_deg_lst : (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
+    auto *dodg_deg_lst = (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
+    off = (OFF *) malloc(sizeof(OFF) * (num_vertices + 1));
+    auto cur_write_off = (OFF *) malloc(sizeof(OFF) * (num_vertices + 1));
+    int32_t *bucket_adj = nullptr;
+    vector<row_ptr_t> histogram;
+
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(dodg_deg_lst, 0, num_vertices + 1);
+        MemSetOMP(off, 0, num_vertices + 1);
+
+        // Histogram (with the multi-edges).
+        if (edge_deg_lst == nullptr) {
+            MemSetOMP(deg_lst, 0, num_vertices + 1);
+            EdgeListHistogram(num_vertices, num_edges, edge_lst, deg_lst, [&edge_lst](size_t it) {
+                return edge_lst[it].first != edge_lst[it].second;
+            });
+        }
+#pragma omp for
+        for (size_t i = 0u; i < num_edges; i++) {
+            auto src = edge_lst[i].first;
+            auto dst = edge_lst[i].second;
+            if (src != dst) {
+                if (RankLT(deg_lst[src], deg_lst[dst], src, dst))
+                    __sync_fetch_and_add(&dodg_deg_lst[src], 1);
+                else
+                    __sync_fetch_and_add(&dodg_deg_lst[dst], 1);
+            }
+        }
+        InclusivePrefixSumOMP(histogram, off + 1, num_vertices, [&dodg_deg_lst](uint32_t it) {
+            return dodg_deg_lst[it];
+        });
+        MemCpyOMP(cur_write_off, off, num_vertices + 1);
+#pragma omp single
+        {
+            bucket_adj = (int32_t *) malloc(sizeof(int32_t) * max<OFF>(off[num_vertices], 1));
+            log_info("[%s]: Histogram Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
+        }
+
+        // Scatter to the Rows.
+#pragma omp for schedule(dynamic, 32*4096/8)
+        for (size_t i = 0; i < num_edges; i++) {
+            auto src = edge_lst[i].first;
+            auto dst = edge_lst[i].second;
+            if (src != dst) {
+                if (!RankLT(deg_lst[src], deg_lst[dst], src, dst)) {
+                    swap(src, dst);
+                }
+                auto old_offset = __sync_fetch_and_add(&(cur_write_off[src]), 1);
+                bucket_adj[old_offset] = dst;
+            }
+        }
+#pragma omp single
+        {
+            free(edge_lst);
+            edge_lst = nullptr;
+            log_info("[%s]: Scatter Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
+        }
+
+        // Per-Row Sort and Deduplication.
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < num_vertices; u++) {
+            auto *beg = bucket_adj + off[u];
+            auto *end = bucket_adj + off[u + 1];
+            sort(beg, end);
+            dodg_deg_lst[u] = unique(beg, end) - beg;
+        }
+
+        // Compaction of the Offsets and the Rows.
+        InclusivePrefixSumOMP(histogram, cur_write_off + 1, num_vertices, [&dodg_deg_lst](uint32_t it) {
+            return dodg_deg_lst[it];
+        });
+#pragma omp single
+        {
+            cur_write_off[0] = 0;
+            adj_lst = (int32_t *) malloc(sizeof(int32_t) * max<OFF>(cur_write_off[num_vertices], 1));
+            log_info("[%s]: Row Sort Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
+        }
+        MemSetOMP(deg_lst, 0, num_vertices + 1);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < num_vertices; u++) {
+            auto *row = adj_lst + cur_write_off[u];
+            memcpy(row, bucket_adj + off[u], sizeof(int32_t) * dodg_deg_lst[u]);
+            // Degrees without the Multi-Edges.
+            __sync_fetch_and_add(&deg_lst[u], dodg_deg_lst[u]);
+            for (auto j = 0u; j < dodg_deg_lst[u]; j++) {
+                __sync_fetch_and_add(&deg_lst[row[j]], 1);
+            }
+        }
+    }
+    swap(off, cur_write_off);
+    free(bucket_adj);
+    free(dodg_deg_lst);
+    free(cur_write_off);
+    log_info("[%s]: Total Conversion Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
+}
+
 inline void ReorderDegDescendingDODG(graph_t &g, vector<int32_t> &new_vid_dict, vector<int32_t> &old_vid_dict,
                                      int32_t *&new_adj, uint32_t *&deg_lst) {
     Timer timer;
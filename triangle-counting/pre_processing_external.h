@@ -0,0 +1,295 @@
+#pragma once
+
+#include <queue>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include <omp.h>
+
+#include "ips4o/ips4o.hpp"
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/primitives.h"
+#include "util/local_buffer.h"
+#include "pre_processing_dodg.h"
+
+/*
+ * External-Memory Pre-Processing: the DODG CSR (as ConvertEdgeListToDODGCSR) of an edge file larger than the memory,
+ * with at most mem_budget bytes of edges in RAM (the vertex arrays and the output adj aside).
+ * 1st: run formation, chunks of mem_budget bytes are read, canonicalized (u < v, no self-loops), sorted (ips4o) and
+ * deduplicated, then spilled as <spill_dir>/tc_run.<i>.
+ * 2nd: k-way merge with deduplication, one key range per thread (the splitters: quantiles of the keys sampled from
+ * the runs, located in each run by binary search), the degrees are counted on the fly and the range is spilled as
+ * <spill_dir>/tc_merged.<tid>.
+ * 3rd: streaming histogram (the DODG out-degrees by RankLT) and CSR scatter, each thread over its merged range.
+ * The spill I/O is sequential, through buffers of at least EXT_MIN_BUF_EDGES, the consumed pages are dropped from
+ * the page cache.
+ */
+#define EXT_IO_REQ_SIZE (1024 * 1024)
+#define EXT_MIN_BUF_EDGES (4096)
+#define EXT_SAMPLES_PER_RUN (1024)
+
+// SpillReader: reads the records [beg, end) of a file sequentially, through a buffer of buffer_cap records.
+template<typename T>
+class SpillReader {
+    int fd_;
+    size_t pos_;        // the next record to read from the file
+    size_t end_;
+    vector<T> buffer_;
+    size_t buffer_idx_;
+    size_t buffer_size_;
+
+    void refill() {
+        buffer_idx_ = 0;
+        buffer_size_ = min(buffer_.size(), end_ - pos_);
+        auto *chars = reinterpret_cast<uint8_t *>(&buffer_.front());
+        size_t total = sizeof(T) * buffer_size_;
+        for (size_t read_size = 0; read_size < total;) {
+            auto ret = pread(fd_, chars + read_size, total - read_size, sizeof(T) * pos_ + read_size);
+            if (ret <= 0) {
+                log_error("Err, %zu, %zu", read_size, total);
+                buffer_size_ = read_size / sizeof(T);
+                break;
+            }
+            read_size += ret;
+        }
+        posix_fadvise(fd_, sizeof(T) * pos_, total, POSIX_FADV_DONTNEED);
+        pos_ += buffer_size_;
+        if (buffer_size_ == 0) {
+            pos_ = end_;
+        }
+    }
+
+public:
+    SpillReader(int fd, size_t beg, size_t end, size_t buffer_cap) :
+            fd_(fd), pos_(beg), end_(end), buffer_(max<size_t>(buffer_cap, 1)), buffer_idx_(0), buffer_size_(0) {
+        posix_fadvise(fd_, sizeof(T) * beg, sizeof(T) * (end - beg), POSIX_FADV_SEQUENTIAL);
+        refill();
+    }
+
+    bool empty() const {
+        return buffer_idx_ == buffer_size_;
+    }
+
+    const T &front() const {
+        return buffer_[buffer_idx_];
+    }
+
+    void pop() {
+        if (++buffer_idx_ == buffer_size_ && pos_ < end_) {
+            refill();
+        }
+    }
+};
+
+// The position of the first record >= key in the sorted records [0, size) of a file.
+template<typename T>
+size_t SpillLowerBound(int fd, size_t size, const T &key) {
+    size_t lo = 0, hi = size;
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        T record;
+        if (pread(fd, &record, sizeof(T), sizeof(T) * mid) != sizeof(T)) {
+            log_error("Err, %zu, %zu", mid, size);
+            return mid;
+        }
+        if (record < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template<typename OFF>
+void ConvertEdgeFileToDODGCSRExternal(const char *file_name, size_t mem_budget, const string &spill_dir,
+                                      int max_omp_threads, uint32_t &num_vertices, uint32_t *&deg_lst, OFF *&off,
+                                      int32_t *&adj_lst) {
+    using Edge = pair<int32_t, int32_t>;
+    Timer convert_timer;
+    size_t num_records = file_size(file_name) / sizeof(Edge);
+    size_t run_cap = max<size_t>(mem_budget / sizeof(Edge), EXT_MIN_BUF_EDGES);
+    auto file_fd = open(file_name, O_RDONLY);
+    if (file_fd < 0) {
+        log_error("Fail to open %s", file_name);
+        return;
+    }
+
+    // 1st: Run Formation.
+    auto *run_buf = (Edge *) malloc(sizeof(Edge) * min(run_cap, max<size_t>(num_records, 1)));
+    vector<string> run_paths;
+    vector<int> run_fds;
+    vector<size_t> run_sizes;
+    vector<Edge> samples;
+    int32_t max_node_id = 0;
+    for (size_t run_beg = 0; run_beg < num_records; run_beg += run_cap) {
+        auto run_size = min(run_cap, num_records - run_beg);
+        auto *chars = reinterpret_cast<uint8_t *>(run_buf);
+#pragma omp parallel for num_threads(max_omp_threads) schedule(dynamic, 1)
+        for (size_t i = 0; i < sizeof(Edge) * run_size; i += EXT_IO_REQ_SIZE) {
+            size_t req_size = min<size_t>(EXT_IO_REQ_SIZE, sizeof(Edge) * run_size - i);
+            auto ret = pread(file_fd, chars + i, req_size, sizeof(Edge) * run_beg + i);
+            if (ret != static_cast<ssize_t>(req_size)) {
+                log_error("Err, %zu, %zu, %zd", i, req_size, ret);
+            }
+        }
+#pragma omp parallel for num_threads(max_omp_threads) reduction(max: max_node_id) schedule(dynamic, 32*1024)
+        for (size_t i = 0; i < run_size; i++) {
+            if (run_buf[i].first > run_buf[i].second) {
+                swap(run_buf[i].first, run_buf[i].second);
+            }
+            max_node_id = max(max_node_id, run_buf[i].second);
+        }
+        ips4o::parallel::sort(run_buf, run_buf + run_size);
+        // Deduplicated and without the self-loops (sequential, at the pace of the write).
+        size_t write = 0;
+        for (size_t i = 0; i < run_size; i++) {
+            if (run_buf[i].first != run_buf[i].second && (write == 0 || run_buf[write - 1] != run_buf[i])) {
+                run_buf[write++] = run_buf[i];
+            }
+        }
+        for (size_t s = 0; s < EXT_SAMPLES_PER_RUN && write > 0; s++) {
+            samples.emplace_back(run_buf[write * s / EXT_SAMPLES_PER_RUN]);
+        }
+        run_paths.emplace_back(spill_dir + "/tc_run." + to_string(run_paths.size()));
+        run_fds.emplace_back(open(run_paths.back().c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR));
+        run_sizes.emplace_back(write);
+        WriteArrayToFd(run_fds.back(), run_buf, write);
+        posix_fadvise(run_fds.back(), 0, 0, POSIX_FADV_DONTNEED);
+    }
+    close(file_fd);
+    free(run_buf);
+    num_vertices = static_cast<uint32_t>(max_node_id) + 1;
+    auto num_runs = run_paths.size();
+    log_info("[%s]: Run Formation Time: %.9lf s, runs: %zu (at most %zu edges)", __FUNCTION__,
+             convert_timer.elapsed(), num_runs, run_cap);
+
+    // 2nd: K-Way Merge, the key range of the thread t: [splitters[t], splitters[t + 1]).
+    sort(samples.begin(), samples.end());
+    vector<vector<size_t>> split_offs(num_runs, vector<size_t>(max_omp_threads + 1, 0));
+    vector<Edge> splitters(max_omp_threads + 1);
+    for (auto t = 1; t < max_omp_threads; t++) {
+        splitters[t] = samples.empty() ? Edge() : samples[samples.size() * t / max_omp_threads];
+    }
+#pragma omp parallel for num_threads(max_omp_threads) schedule(dynamic, 1)
+    for (size_t r = 0; r < num_runs; r++) {
+        for (auto t = 1; t < max_omp_threads; t++) {
+            split_offs[r][t] = SpillLowerBound(run_fds[r], run_sizes[r], splitters[t]);
+        }
+        split_offs[r][max_omp_threads] = run_sizes[r];
+    }
+    deg_lst = (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
+    auto *dodg_deg_lst = (uint32_t *) malloc(sizeof(uint32_t) * (num_vertices + 1));
+    off = (OFF *) malloc(sizeof(OFF) * (num_vertices + 1));
+    auto cur_write_off = (OFF *) malloc(sizeof(OFF) * (num_vertices + 1));
+    vector<size_t> merged_sizes(max_omp_threads, 0);
+    vector<int> merged_fds(max_omp_threads);
+    vector<row_ptr_t> histogram;
+    // The buffers of a thread: one per run, and one for the output.
+    size_t buf_cap = max<size_t>(mem_budget / sizeof(Edge) / max_omp_threads / (num_runs + 1), EXT_MIN_BUF_EDGES);
+    double merge_time = 0;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        auto tid = omp_get_thread_num();
+        MemSetOMP(deg_lst, 0, num_vertices + 1);
+        MemSetOMP(dodg_deg_lst, 0, num_vertices + 1);
+        MemSetOMP(off, 0, num_vertices + 1);
+        auto merged_path = spill_dir + "/tc_merged." + to_string(tid);
+        merged_fds[tid] = open(merged_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        unlink(merged_path.c_str());
+        {
+            vector<SpillReader<Edge>> readers;
+            using HeapEntry = pair<Edge, uint32_t>;
+            priority_queue<HeapEntry, vector<HeapEntry>, greater<HeapEntry>> heap;
+            for (size_t r = 0; r < num_runs; r++) {
+                readers.emplace_back(run_fds[r], split_offs[r][tid], split_offs[r][tid + 1], buf_cap);
+                if (!readers.back().empty()) {
+                    heap.emplace(readers.back().front(), r);
+                }
+            }
+            vector<Edge> out_buf(buf_cap);
+            auto flush = [&merged_fds, tid](Edge *buf, size_t size) { WriteArrayToFd(merged_fds[tid], buf, size); };
+            LocalFlushBuffer<Edge, size_t, decltype(flush)> out(&out_buf.front(), buf_cap, flush);
+            Edge last(-1, -1);
+            size_t merged_size = 0;
+            while (!heap.empty()) {
+                auto entry = heap.top();
+                heap.pop();
+                auto &reader = readers[entry.second];
+                reader.pop();
+                if (!reader.empty()) {
+                    heap.emplace(reader.front(), entry.second);
+                }
+                if (entry.first == last) {
+                    continue;
+                }
+                last = entry.first;
+                __sync_fetch_and_add(&deg_lst[last.first], 1);
+                __sync_fetch_and_add(&deg_lst[last.second], 1);
+                out.push(last);
+                merged_size++;
+            }
+            out.submit_if_possible();
+            merged_sizes[tid] = merged_size;
+        }
+#pragma omp barrier
+#pragma omp single
+        {
+            for (size_t r = 0; r < num_runs; r++) {
+                close(run_fds[r]);
+                unlink(run_paths[r].c_str());
+            }
+            merge_time = convert_timer.elapsed();
+            log_info("[%s]: Merge Time: %.9lf s, Mem Usage: %s KB", __FUNCTION__, merge_time,
+                     FormatWithCommas(getValue()).c_str());
+        }
+
+        // 3rd: Histogram and Scatter, streaming over the merged range.
+        auto for_each_merged = [&](auto f) {
+            SpillReader<Edge> reader(merged_fds[tid], 0, merged_sizes[tid], buf_cap);
+            for (; !reader.empty(); reader.pop()) {
+                f(reader.front());
+            }
+        };
+        for_each_merged([&](const Edge &e) {
+            auto src = e.first, dst = e.second;
+            if (RankLT(deg_lst[src], deg_lst[dst], src, dst))
+                __sync_fetch_and_add(&dodg_deg_lst[src], 1);
+            else
+                __sync_fetch_and_add(&dodg_deg_lst[dst], 1);
+        });
+#pragma omp barrier
+        InclusivePrefixSumOMP(histogram, off + 1, num_vertices, [&dodg_deg_lst](uint32_t it) {
+            return dodg_deg_lst[it];
+        });
+        MemCpyOMP(cur_write_off, off, num_vertices + 1);
+#pragma omp single
+        {
+            log_info("[%s]: Histogram Time: %.9lf s", __FUNCTION__, convert_timer.elapsed());
+            if (adj_lst == nullptr) {
+                log_info("Allocate Inside (adj_lst)...");
+                adj_lst = (int32_t *) malloc(sizeof(int32_t) * max<OFF>(off[num_vertices], 1));
+            }
+        }
+        for_each_merged([&](const Edge &e) {
+            auto src = e.first, dst = e.second;
+            if (!RankLT(deg_lst[src], deg_lst[dst], src, dst)) {
+                swap(src, dst);
+            }
+            auto old_offset = __sync_fetch_and_add(&(cur_write_off[src]), 1);
+            adj_lst[old_offset] = dst;
+        });
+        close(merged_fds[tid]);
+    }
+    free(dodg_deg_lst);
+    free(cur_write_off);
+    log_info("[%s]: Total Conversion Time: %.9lf s (merge: %.9lf s), budget: %zu MB, records: %zu, edges: %zu",
+             __FUNCTION__, convert_timer.elapsed(), merge_time, mem_budget / 1024 / 1024, num_records,
+             static_cast<size_t>(off[num_vertices]));
+}
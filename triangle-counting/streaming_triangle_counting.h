@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+#include <malloc.h>
+
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "approx_triangle_counting.h"
+
+/*
+ * Streaming Triangle Estimation under a memory budget: one pass over the binary edge list, without loading it.
+ * The edges are read with O_DIRECT preads of STREAM_IO_REQ_SIZE (as the DIO loader of main), io_queue_depth in flight,
+ * and each edge (u < v) is kept with the probability rate by a hash of (u, v) (MASCOT-style independent sampling, so
+ * that the multi-edges are kept or dropped together and the sampling runs at the pace of the reads).
+ * The reservoir holds at most budget edges: rate starts at (budget - STREAM_RATE_SIGMAS * sqrt(budget)) / #records, so
+ * that the binomial noise rarely fills it up; if it does, rate halves and the reservoir is compacted to the edges still
+ * under it.
+ * The kept edges go through the usual DODG pipeline, the estimate and its variance are then the edge-sampling ones
+ * (EstimateTriSparsified): T_s / rate^3, with the term of the triangle pairs sharing an edge.
+ */
+#define STREAM_PAGE_SIZE (4096)
+#define STREAM_IO_REQ_SIZE (STREAM_PAGE_SIZE * 32)
+#define STREAM_FLUSH_EDGES (4096)
+#define STREAM_RATE_SIGMAS (4)
+// The peak bytes per kept edge: the sample, its page-cache copy, the DODG adj and its reordered copy, the support.
+#define STREAM_BYTES_PER_EDGE (28)
+
+inline double StreamEdgeHash(uint64_t seed, const pair<int32_t, int32_t> &e) {
+    return HashUniform(seed, (static_cast<uint64_t>(e.first) << 32) | static_cast<uint32_t>(e.second));
+}
+
+/*
+ * StreamSampleEdgeFile: the kept edges (malloc, u < v, unsorted, with the multi-edges), num_sampled: their number,
+ * rate: the final keep probability.
+ */
+inline pair<int32_t, int32_t> *StreamSampleEdgeFile(const char *file_name, int io_queue_depth, size_t budget,
+                                                    uint64_t seed, size_t &num_sampled, double &rate) {
+    using Edge = pair<int32_t, int32_t>;
+    Timer timer;
+    size_t size = file_size(file_name);
+    size_t num_records = size / sizeof(Edge);
+    budget = max<size_t>(budget, 1);
+    rate = min(1.0, max(budget - STREAM_RATE_SIGMAS * sqrt(budget), 1.0) / max<size_t>(num_records, 1));
+    auto *sample = (Edge *) malloc(sizeof(Edge) * budget);
+    num_sampled = 0;
+    auto file_fd = open(file_name, O_RDONLY | O_DIRECT);
+    if (file_fd < 0) {
+        log_error("Fail to open %s", file_name);
+        return sample;
+    }
+
+    size_t read_size = 0, num_halvings = 0;
+    // Appends the kept edges of a thread, halving the rate while they do not fit.
+    auto flush = [&](vector<Edge> &local) {
+#pragma omp critical
+        {
+            auto keep_under = [&](Edge *edges, size_t num) {
+                return static_cast<size_t>(remove_if(edges, edges + num, [&](const Edge &e) {
+                    return StreamEdgeHash(seed, e) >= rate;
+                }) - edges);
+            };
+            local.resize(keep_under(local.data(), local.size()));
+            while (num_sampled + local.size() > budget) {
+                double half_rate = rate / 2;
+#pragma omp atomic write
+                rate = half_rate;
+                num_halvings++;
+                num_sampled = keep_under(sample, num_sampled);
+                local.resize(keep_under(local.data(), local.size()));
+            }
+            copy(local.begin(), local.end(), sample + num_sampled);
+            num_sampled += local.size();
+        }
+        local.clear();
+    };
+#pragma omp parallel num_threads(io_queue_depth) reduction(+:read_size)
+    {
+        auto *buf = (Edge *) memalign(STREAM_PAGE_SIZE, STREAM_IO_REQ_SIZE);
+        vector<Edge> local;
+        local.reserve(STREAM_FLUSH_EDGES + STREAM_IO_REQ_SIZE / sizeof(Edge));
+#pragma omp for schedule(dynamic, 1)
+        for (size_t i = 0; i < size; i += STREAM_IO_REQ_SIZE) {
+            auto ret = pread(file_fd, buf, STREAM_IO_REQ_SIZE, i);
+            if (ret < 0 || (ret < STREAM_IO_REQ_SIZE && i + ret < size)) {
+                log_error("Err, %zu, %d, %zd", i, STREAM_IO_REQ_SIZE, ret);
+            }
+            if (ret <= 0) {
+                continue;
+            }
+            read_size += ret;
+            double cur_rate;
+#pragma omp atomic read
+            cur_rate = rate;
+            for (size_t j = 0; j < ret / sizeof(Edge); j++) {
+                auto e = buf[j];
+                if (e.first == e.second) {
+                    continue;
+                }
+                if (e.first > e.second) {
+                    swap(e.first, e.second);
+                }
+                if (StreamEdgeHash(seed, e) < cur_rate) {
+                    local.emplace_back(e);
+                }
+            }
+            if (local.size() >= STREAM_FLUSH_EDGES) {
+                flush(local);
+            }
+        }
+        flush(local);
+        free(buf);
+    }
+    close(file_fd);
+    auto elapsed = timer.elapsed();
+    log_info("Stream Time: %.3lfs, read: %zu / %zu bytes, %.3lf GB/s", elapsed, read_size, size,
+             read_size / elapsed / pow(1024, 3));
+    log_info("Stream Sample: %'zu of %'zu records kept (budget: %'zu), rate: %.9lf, halvings: %zu", num_sampled,
+             num_records, budget, rate, num_halvings);
+    return sample;
+}
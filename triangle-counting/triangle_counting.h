@@ -1,39 +1,370 @@
 #pragma once
 
+#include <malloc.h>
+
+#include <limits>
+#include <numeric>
+#include <string>
+
 #include "util/boolarray.h"
 #include "util/graph.h"
 #include "util/libpopcnt.h"
 #include "util/set_inter_cnt_utils.h"
+#include "util/set_inter_emit_utils.h"
+#include "util/set_inter_adaptive.h"
+#include "util/dense_ranges.h"
+#include "util/chunk_scheduler.h"
+#include "util/local_buffer.h"
+#include "util/gather_and_popcnt.h"
 
+// Fixed first range of the listing and the per-vertex/per-edge kernels, the counting plans it (PlanDenseRanges).
 #define MAX_PACK_NUM (32768)
 #define FIRST_RANGE_SIZE (32768)
+#define LIST_BUFFER_SIZE (64 * 1024)
+
+// Counting engines, bmp-merge: below, hash-jik: triangle_counting_hash_jik.h, roaring: triangle_counting_roaring.h,
+// tiled: triangle_counting_tiled.h, spgemm: triangle_counting_spgemm.h.
+enum tc_engine_t {
+    ENGINE_BMP_MERGE = 0, ENGINE_HASH_JIK = 1, ENGINE_ROARING = 2, ENGINE_TILED = 3,
+    ENGINE_SPGEMM = 4
+};
+
+inline const char *TCEngineName(tc_engine_t engine) {
+    static const char *names[] = {"bmp-merge", "hash-jik", "roaring", "tiled", "spgemm"};
+    return names[engine];
+}
+
+inline tc_engine_t ParseTCEngine(const std::string &name) {
+    for (auto it = ENGINE_BMP_MERGE; it <= ENGINE_SPGEMM; it = static_cast<tc_engine_t>(it + 1)) {
+        if (name == TCEngineName(it)) {
+            return it;
+        }
+    }
+    log_warn("Unknown engine: %s, use %s", name.c_str(), TCEngineName(ENGINE_BMP_MERGE));
+    return ENGINE_BMP_MERGE;
+}
+
+struct triangle_t {
+    int32_t u;
+    int32_t v;
+    int32_t w;
+};
 
-template<typename OFF, typename WI, typename WC>
-void PackWords(graph_t &g, OFF *row_ptrs_beg, int to_pack_num, vector<vector<WI>> &word_indexes,
-               vector<vector<WC>> &words, Timer &tc_timer) {
+// The packed words of u < to_pack_num: [word_ptrs[u], word_ptrs[u + 1]) of word_indexes (the word IDs) and words.
+template<typename WI, typename WC>
+struct packed_words_t {
+    size_t *word_ptrs;
+    WI *word_indexes;
+    WC *words;
+};
+
+template<typename WI, typename WC>
+void FreePackedWords(packed_words_t<WI, WC> &packed) {
+    free(packed.word_ptrs);
+    free(packed.word_indexes);
+    free(packed.words);
+}
+
+/*
+ * PackWords: called inside a parallel region, one word per 64 vertices for the neighbors of u in [g.row_ptrs[u],
+ * row_ptrs_beg[u]), 1st pass: the words per vertex prefix-summed, 2nd pass: fills the cache-line-aligned arrays.
+ */
+template<typename OFF, typename WI, typename WC, typename H>
+void PackWords(graph_t &g, OFF *row_ptrs_beg, int to_pack_num, packed_words_t<WI, WC> &packed,
+               vector<H> &histogram, Timer &tc_timer) {
     constexpr int word_in_bits = sizeof(WC) * 8;
-    // Construct Words for Range [0, 32768), at most 512 words (given each word 64 bits)
+#pragma omp single
+    {
+        packed.word_ptrs = (size_t *) memalign(64, sizeof(size_t) * (to_pack_num + 1));
+        packed.word_ptrs[0] = 0;
+    }
+    InclusivePrefixSumOMP(histogram, packed.word_ptrs + 1, to_pack_num, [&g, row_ptrs_beg](size_t u) {
+        size_t num_words = 0;
+        auto prev_blk_id = -1;
+        for (auto off = g.row_ptrs[u]; off < row_ptrs_beg[u]; off++) {
+            int cur_blk_id = g.adj[off] / word_in_bits;
+            num_words += cur_blk_id != prev_blk_id;
+            prev_blk_id = cur_blk_id;
+        }
+        return num_words;
+    });
+#pragma omp single
+    {
+        auto num_words = max<size_t>(packed.word_ptrs[to_pack_num], 1);
+        packed.word_indexes = (WI *) memalign(64, sizeof(WI) * num_words);
+        packed.words = (WC *) memalign(64, sizeof(WC) * num_words);
+    }
+    // Construct Words for the First Range [0, row_ptrs_beg)
 #pragma omp for schedule(dynamic, 100)
     for (auto u = 0u; u < to_pack_num; u++) {
         auto prev_blk_id = -1;
+        auto word_idx = packed.word_ptrs[u];
         for (auto off = g.row_ptrs[u]; off < row_ptrs_beg[u]; off++) {
             auto v = g.adj[off];
             int cur_blk_id = v / word_in_bits;
             if (cur_blk_id != prev_blk_id) {
                 prev_blk_id = cur_blk_id;
-                word_indexes[u].emplace_back(cur_blk_id);
-                words[u].emplace_back(0);
+                packed.word_indexes[word_idx] = cur_blk_id;
+                packed.words[word_idx++] = 0;
             }
-            words[u].back() |= static_cast<WC>(1u) << (v % word_in_bits);
+            packed.words[word_idx - 1] |= static_cast<WC>(1u) << (v % word_in_bits);
         }
     }
 #pragma omp single
     {
-        log_info("Finish Indexing: %.9lfs", tc_timer.elapsed());
+        log_info("Finish Indexing: %.9lfs, packed words: %zu", tc_timer.elapsed(), packed.word_ptrs[to_pack_num]);
     }
 }
 
-inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
+/*
+ * CountTriBMPAndMergeWithPackDODG: the ranges (see PlanDenseRanges) are processed one by one per u,
+ * a bitmap range indexes u's neighbors in it (packed words in the first one) and intersects v's neighbors in it
+ * (merge, galloping or probe, see SelectSetInterPath), the last range intersects with the merge or the galloping.
+ * sched: the scheduling of the loop over u (see BalancedChunksOMP).
+ */
+inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads, tc_sched_t sched = SCHED_BALANCED) {
+    Timer tc_timer;
+    int max_d = 0;
+    size_t tc_cnt = 0;
+    using word_t = uint64_t;
+
+    auto plan = PlanDenseRanges(g, max_omp_threads);
+    auto &bounds = plan.bounds;
+    int num_ranges = plan.num_ranges();
+    int num_inner_bounds = num_ranges - 1;
+    // Offsets (relative to g.row_ptrs[u]) of u's first neighbor in the ranges [1, num_ranges).
+    auto *range_offs = (uint32_t *) malloc(sizeof(uint32_t) * max<size_t>(1, g.n * num_inner_bounds));
+    auto range_off = [&](uint32_t u, int r) -> row_ptr_t {
+        if (r == 0) { return g.row_ptrs[u]; }
+        if (r == num_ranges) { return g.row_ptrs[u + 1]; }
+        return g.row_ptrs[u] + range_offs[static_cast<size_t>(u) * num_inner_bounds + r - 1];
+    };
+
+    int to_pack_num = bounds[1];
+    auto *row_ptrs_pack_end = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max(to_pack_num, 1));
+    packed_words_t<uint16_t, word_t> packed{};     // word IDs: at most DENSE_RANGE_MAX_PACK_BITS / bits-sizeof(word)
+    vector<set_inter_cost_model_t> cost_models(num_ranges);
+    for (auto r = 0; r < num_ranges - 1; r++) {
+        cost_models[r] = CalibrateSetInterCostModel(max(bounds[r + 1] - bounds[r], 1));
+    }
+    cost_models[num_ranges - 1] = cost_models[max(num_ranges - 2, 0)];
+    size_t path_cnt[SET_INTER_PATH_NUM] = {0};
+
+    // Balanced and Steal Schedulers.
+    vector<size_t> histogram;
+    auto *work_prefix = sched != SCHED_DYNAMIC ? (size_t *) malloc(sizeof(size_t) * max<long>(g.n, 1)) : nullptr;
+    vector<uint32_t> chunk_bounds;
+    int chunk_cursor = 0;
+    size_t num_heavy = 0;
+    size_t num_sub_tasks = 0;
+    vector<double> busy_time(max_omp_threads, 0);
+    // The time (of tc_timer) each thread finishes its last chunk or sub-task, against the end of the loop.
+    vector<double> done_time(max_omp_threads, 0);
+
+    // Per-thread bitmaps, the stolen sub-tasks (SCHED_STEAL) use the ones of the thread running them.
+    vector<BoolArray<word_t>> bitmaps;
+    for (auto tid = 0; tid < max_omp_threads; tid++) {
+        bitmaps.emplace_back(plan.max_bitmap_range);
+    }
+    // Counts the triangles of the out-edges [edge_beg, edge_end) of u.
+    auto count_tri_u = [&](uint32_t u, row_ptr_t edge_beg, row_ptr_t edge_end, size_t &local_tc_cnt,
+                           size_t *local_path_cnt) {
+        auto tid = omp_get_thread_num();
+        auto &bitmap = bitmaps[tid];
+        for (auto r = 0; r < num_ranges; r++) {
+            auto off_beg_u = range_off(u, r);
+            auto off_end_u = range_off(u, r + 1);
+            auto du = off_end_u - off_beg_u;
+            if (du == 0) {
+                continue;
+            }
+            auto kind = plan.kind(r);
+            auto base = bounds[r];
+            auto is_packed_u = kind == RANGE_BITMAP_PACK && u < static_cast<uint32_t>(to_pack_num);
+            // Index for the Range.
+            if (kind != RANGE_MERGE) {
+                if (is_packed_u) {
+                    for (auto i = packed.word_ptrs[u]; i < packed.word_ptrs[u + 1]; i++) {
+                        bitmap.setWord(packed.word_indexes[i], packed.words[i]);
+                    }
+                } else {
+                    for (auto off = off_beg_u; off < off_end_u; off++) {
+                        bitmap.set(g.adj[off] - base);
+                    }
+                }
+            }
+
+            for (auto edge_idx = edge_beg; edge_idx < edge_end; edge_idx++) {
+                auto v = g.adj[edge_idx];
+                if (kind == RANGE_BITMAP_PACK && v < to_pack_num) {
+                    auto *word_indexes_v = packed.word_indexes + packed.word_ptrs[v];
+                    auto *words_v = packed.words + packed.word_ptrs[v];
+                    auto num_words_v = packed.word_ptrs[v + 1] - packed.word_ptrs[v];
+                    local_tc_cnt += GatherAndPopcnt(bitmap.words(), word_indexes_v, words_v, num_words_v);
+                    continue;
+                }
+                auto off_beg_v = range_off(v, r);
+                auto off_end_v = range_off(v, r + 1);
+                auto dv = off_end_v - off_beg_v;
+                if (dv == 0) {
+                    continue;
+                }
+                auto path = SelectSetInterPath(cost_models[r], du, dv, kind != RANGE_MERGE);
+                local_path_cnt[path]++;
+                if (path == SET_INTER_PATH_PROBE) {
+                    local_tc_cnt += BitmapProbeCnt(&g, bitmap, base, off_beg_v, off_end_v);
+                } else if (path == SET_INTER_PATH_LOOKUP) {
+                    local_tc_cnt += SetInterLookup(&g, off_beg_u, off_end_u, off_beg_v, off_end_v);
+                } else {
+                    local_tc_cnt += SetInterCntVecMerge(&g, off_beg_u, off_end_u, off_beg_v, off_end_v);
+                }
+            }
+
+            // Clear the Index, proportional to du instead of the range size.
+            if (kind != RANGE_MERGE) {
+                if (is_packed_u) {
+                    for (auto i = packed.word_ptrs[u]; i < packed.word_ptrs[u + 1]; i++) {
+                        bitmap.setWord(packed.word_indexes[i], 0);
+                    }
+                } else {
+                    for (auto off = off_beg_u; off < off_end_u; off++) {
+                        bitmap.unset(g.adj[off] - base);
+                    }
+                }
+            }
+        }
+    };
+    // Splits the out-edges of a heavy u into sub-tasks of about task_work each, idle threads steal them.
+    auto spawn_sub_tasks = [&](uint32_t u, size_t task_work) {
+        auto du = g.row_ptrs[u + 1] - g.row_ptrs[u];
+        auto edge_beg = g.row_ptrs[u];
+        size_t acc_work = 0;
+        for (auto edge_idx = g.row_ptrs[u]; edge_idx < g.row_ptrs[u + 1]; edge_idx++) {
+            auto v = g.adj[edge_idx];
+            acc_work += du + g.row_ptrs[v + 1] - g.row_ptrs[v];
+            if (acc_work >= task_work || edge_idx + 1 == g.row_ptrs[u + 1]) {
+                auto edge_end = edge_idx + 1;
+                // Pointers: the captured references would be firstprivate in the (orphaned) task.
+                auto *count_fn = &count_tri_u;
+                auto *shared_tc_cnt = &tc_cnt;
+                auto *shared_path_cnt = path_cnt;
+                auto *shared_busy_time = &busy_time.front();
+                auto *shared_done_time = &done_time.front();
+                auto *shared_timer = &tc_timer;
+#pragma omp task firstprivate(u, edge_beg, edge_end, count_fn, shared_tc_cnt, shared_path_cnt, shared_busy_time, \
+        shared_done_time, shared_timer)
+                {
+                    Timer task_timer;
+                    size_t task_tc_cnt = 0;
+                    size_t task_path_cnt[SET_INTER_PATH_NUM] = {0};
+                    (*count_fn)(u, edge_beg, edge_end, task_tc_cnt, task_path_cnt);
+                    __sync_fetch_and_add(shared_tc_cnt, task_tc_cnt);
+                    for (auto path = 0; path < SET_INTER_PATH_NUM; path++) {
+                        __sync_fetch_and_add(&shared_path_cnt[path], task_path_cnt[path]);
+                    }
+                    shared_busy_time[omp_get_thread_num()] += task_timer.elapsed();
+                    shared_done_time[omp_get_thread_num()] = shared_timer->elapsed();
+                }
+                __sync_fetch_and_add(&num_sub_tasks, 1);
+                edge_beg = edge_end;
+                acc_work = 0;
+            }
+        }
+    };
+
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+#pragma omp for reduction(max: max_d)
+        for (auto u = 0u; u < g.n; u++) {
+            for (auto r = 1; r < num_ranges; r++) {
+                range_offs[static_cast<size_t>(u) * num_inner_bounds + r - 1] =
+                        lower_bound(g.adj + g.row_ptrs[u], g.adj + g.row_ptrs[u + 1], bounds[r]) -
+                        (g.adj + g.row_ptrs[u]);
+            }
+            if (u < static_cast<uint32_t>(to_pack_num)) {
+                row_ptrs_pack_end[u] = range_off(u, 1);
+            }
+            max_d = max<int>(max_d, g.row_ptrs[u + 1] - g.row_ptrs[u]);
+        }
+#pragma omp single
+        {
+            log_info("finish init range offsets, max d: %d, time: %.9lfs", max_d, tc_timer.elapsed());
+        }
+
+        PackWords(g, row_ptrs_pack_end, to_pack_num, packed, histogram, tc_timer);
+
+        auto tid = omp_get_thread_num();
+        if (sched == SCHED_DYNAMIC) {
+            Timer busy_timer;
+#pragma omp for schedule(dynamic, 100) reduction(+:tc_cnt) reduction(+:path_cnt[:SET_INTER_PATH_NUM]) nowait
+            for (auto u = 0u; u < g.n; u++) {
+                count_tri_u(u, g.row_ptrs[u], g.row_ptrs[u + 1], tc_cnt, path_cnt);
+            }
+            busy_time[tid] += busy_timer.elapsed();
+            done_time[tid] = tc_timer.elapsed();
+        } else {
+            BalancedChunksOMP(g, histogram, work_prefix, chunk_bounds);
+            auto chunk_work = g.n > 0 ? work_prefix[g.n - 1] / (max_omp_threads * CHUNKS_PER_THREAD) : 0;
+            auto heavy_work = sched == SCHED_STEAL ? chunk_work : numeric_limits<size_t>::max();
+            size_t local_tc_cnt = 0;
+            size_t local_path_cnt[SET_INTER_PATH_NUM] = {0};
+            int num_chunks = chunk_bounds.size() - 1;
+            for (auto chunk = __sync_fetch_and_add(&chunk_cursor, 1); chunk < num_chunks;
+                 chunk = __sync_fetch_and_add(&chunk_cursor, 1)) {
+                Timer busy_timer;
+                // The sub-tasks this thread runs inside the chunk (undeferred, or at the scheduling point of their
+                // creation) add their own time, it is taken out of the chunk's.
+                auto task_busy_time = busy_time[tid];
+                for (auto u = chunk_bounds[chunk]; u < chunk_bounds[chunk + 1]; u++) {
+                    auto work_u = work_prefix[u] - (u > 0 ? work_prefix[u - 1] : 0);
+                    if (work_u > heavy_work && g.row_ptrs[u + 1] - g.row_ptrs[u] > 1) {
+                        __sync_fetch_and_add(&num_heavy, 1);
+                        spawn_sub_tasks(u, chunk_work);
+                    } else {
+                        count_tri_u(u, g.row_ptrs[u], g.row_ptrs[u + 1], local_tc_cnt, local_path_cnt);
+                    }
+                }
+                task_busy_time = busy_time[tid] - task_busy_time;
+                busy_time[tid] += busy_timer.elapsed() - task_busy_time;
+            }
+            __sync_fetch_and_add(&tc_cnt, local_tc_cnt);
+            for (auto path = 0; path < SET_INTER_PATH_NUM; path++) {
+                __sync_fetch_and_add(&path_cnt[path], local_path_cnt[path]);
+            }
+            done_time[tid] = max(done_time[tid], tc_timer.elapsed());
+        }
+        // The remaining sub-tasks are run by the threads reaching the implicit barrier.
+    }
+    auto loop_end_time = tc_timer.elapsed();
+    free(range_offs);
+    free(row_ptrs_pack_end);
+    FreePackedWords(packed);
+    free(work_prefix);
+    log_info("Forward cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
+    auto max_busy_time = *max_element(busy_time.begin(), busy_time.end());
+    auto avg_busy_time = accumulate(busy_time.begin(), busy_time.end(), 0.0) / max_omp_threads;
+    log_info("Forward Scheduler: %s, heavy vertices: %zu, sub-tasks: %zu", TCSchedName(sched), num_heavy,
+             num_sub_tasks);
+    log_info("Forward Busy Time, max: %.6lfs, avg: %.6lfs, tail (max - avg): %.6lfs", max_busy_time, avg_busy_time,
+             max_busy_time - avg_busy_time);
+    auto max_idle_time = loop_end_time - *min_element(done_time.begin(), done_time.end());
+    auto avg_idle_time = loop_end_time - accumulate(done_time.begin(), done_time.end(), 0.0) / max_omp_threads;
+    log_info("Forward Idle Time at the End of the Loop, max: %.6lfs, avg: %.6lfs", max_idle_time, avg_idle_time);
+    log_info("Intersection Paths, merge: %'zu, lookup: %'zu, probe: %'zu", path_cnt[SET_INTER_PATH_MERGE],
+             path_cnt[SET_INTER_PATH_LOOKUP], path_cnt[SET_INTER_PATH_PROBE]);
+    log_info("Triangle Cnt: %'zu", tc_cnt);
+    return tc_cnt;
+}
+
+/*
+ * EnumerateTriBMPAndMergeDODG: visits each triangle of the DODG exactly once, same two ranges as the counting.
+ * First Range: the neighbors of v are probed against the bitmap of u (remembering the offsets of u's neighbors).
+ * Second Range: vectorized merge, emitting the offsets of the matches.
+ * f(u, edge_idx, cnt, off_u_lst, off_v_lst): called per edge (u, v = g.adj[edge_idx]) with cnt > 0 triangles,
+ * the i-th one is (u, v, w), w = g.adj[off_u_lst[i]] = g.adj[off_v_lst[i]]
+ */
+template<typename F>
+size_t EnumerateTriBMPAndMergeDODG(graph_t &g, int max_omp_threads, F f) {
     Timer tc_timer;
     int max_d = 0;
     size_t tc_cnt = 0;
@@ -41,11 +372,6 @@ inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
 
     auto *row_ptrs_end = g.row_ptrs;
     using word_t = uint64_t;
-    constexpr int word_in_bits = sizeof(word_t) * 8;
-
-    int to_pack_num = min<int>(g.n, MAX_PACK_NUM);
-    vector<vector<uint16_t>> word_indexes(to_pack_num);   // MAX_PACK_NUM * bits-sizeof(word)
-    vector<vector<word_t>> words(to_pack_num);
 
 #pragma omp parallel num_threads(max_omp_threads)
     {
@@ -56,32 +382,21 @@ inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
             max_d = max<int>(max_d, g.row_ptrs[u + 1] - g.row_ptrs[u]);
         }
 #pragma omp single
-        {
-            if (to_pack_num > 0) {
-                log_info("Stop Deg at [%d, %d]", g.row_ptrs[1] - g.row_ptrs[0],
-                         g.row_ptrs[to_pack_num] - g.row_ptrs[to_pack_num - 1]);
-            }
-            log_info("finish init row_ptrs_end, max d: %d, time: %.9lfs", max_d, tc_timer.elapsed());
-        }
+        log_info("finish init row_ptrs_end, max d: %d, time: %.9lfs", max_d, tc_timer.elapsed());
 
-        PackWords(g, row_ptrs_beg, to_pack_num, word_indexes, words, tc_timer);
+        // #of matches of an edge <= min(du, dv) <= max_d.
+        BoolArray<word_t> bitmap(FIRST_RANGE_SIZE);
+        vector<row_ptr_t> bitmap_off(FIRST_RANGE_SIZE);
+        vector<row_ptr_t> off_u_lst(max_d);
+        vector<row_ptr_t> off_v_lst(max_d);
 
 #pragma omp for schedule(dynamic, 100) reduction(+:tc_cnt)
         for (auto u = 0u; u < g.n; u++) {
-            static thread_local BoolArray<word_t> bitmap(FIRST_RANGE_SIZE);
-            static thread_local vector<word_t> buffer(FIRST_RANGE_SIZE / word_in_bits);
             //  Index for First Range.
-            if (g.row_ptrs[u] < row_ptrs_beg[u]) {
-                if (u < to_pack_num) {
-                    for (size_t i = 0; i < word_indexes[u].size(); i++) {
-                        bitmap.setWord(word_indexes[u][i], words[u][i]);
-                    }
-                } else {
-                    for (auto off = g.row_ptrs[u]; off < row_ptrs_beg[u]; off++) {
-                        auto w = g.adj[off];
-                        bitmap.set(w);
-                    }
-                }
+            for (auto off = g.row_ptrs[u]; off < row_ptrs_beg[u]; off++) {
+                auto w = g.adj[off];
+                bitmap.set(w);
+                bitmap_off[w] = off;
             }
             auto du = row_ptrs_end[u + 1] - row_ptrs_beg[u];
 
@@ -90,19 +405,12 @@ inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
                 auto cn_count = 0;
                 // First Range.
                 if (g.row_ptrs[u] < row_ptrs_beg[u]) {
-                    if (v < to_pack_num) {
-                        auto num_words_v = word_indexes[v].size();
-                        for (size_t i = 0; i < num_words_v; i++) {
-                            buffer[i] = bitmap.getWord(word_indexes[v][i]);
-                        }
-                        for (size_t i = 0; i < num_words_v; i++) {
-                            buffer[i] &= words[v][i];
-                        }
-                        cn_count += popcnt(&buffer.front(), sizeof(word_t) * num_words_v);
-                    } else {
-                        if (g.row_ptrs[v] < row_ptrs_beg[v]) {
-                            cn_count += SetInterCntVecMerge(&g, g.row_ptrs[u], row_ptrs_beg[u], g.row_ptrs[v],
-                                                            row_ptrs_beg[v]);
+                    for (auto off = g.row_ptrs[v]; off < row_ptrs_beg[v]; off++) {
+                        auto w = g.adj[off];
+                        if (bitmap.get(w)) {
+                            off_u_lst[cn_count] = bitmap_off[w];
+                            off_v_lst[cn_count] = off;
+                            cn_count++;
                         }
                     }
                 }
@@ -110,10 +418,14 @@ inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
                 // Second Range.
                 auto dv = row_ptrs_end[v + 1] - row_ptrs_beg[v];
                 if (du > 0 && dv > 0) {
-                    cn_count += SetInterCntVecMerge(&g, row_ptrs_beg[u], row_ptrs_end[u + 1],
-                                                    row_ptrs_beg[v], row_ptrs_end[v + 1]);
+                    cn_count += SetInterEmitVecMerge(&g, row_ptrs_beg[u], row_ptrs_end[u + 1],
+                                                     row_ptrs_beg[v], row_ptrs_end[v + 1],
+                                                     &off_u_lst[cn_count], &off_v_lst[cn_count]);
+                }
+                if (cn_count > 0) {
+                    f(u, edge_idx, cn_count, &off_u_lst.front(), &off_v_lst.front());
+                    tc_cnt += cn_count;
                 }
-                tc_cnt += cn_count;
             }
 
             // Clear the Index.
@@ -123,11 +435,154 @@ inline size_t CountTriBMPAndMergeWithPackDODG(graph_t &g, int max_omp_threads) {
         }
     }
     free(row_ptrs_beg);
-    log_info("Forward cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
+    log_info("Enumerate cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
     log_info("Triangle Cnt: %'zu", tc_cnt);
     return tc_cnt;
 }
 
+/*
+ * ListTriDODG: streams each triangle (u, v, w) (new IDs) through a thread-local LocalFlushBuffer,
+ * sink(tid, tri_lst, size) gets the full buffers of thread tid (calls with the same tid never overlap).
+ */
+template<typename S>
+size_t ListTriDODG(graph_t &g, int max_omp_threads, S sink) {
+    Timer timer;
+    auto make_flush = [&sink](int tid) {
+        return [&sink, tid](triangle_t *tri_lst, uint32_t size) {
+            sink(tid, tri_lst, size);
+        };
+    };
+    using BufT = LocalFlushBuffer<triangle_t, uint32_t, decltype(make_flush(0))>;
+    // Cache-line aligned, avoid false sharing on the buffer sizes.
+    constexpr size_t buf_stride = (sizeof(BufT) + 63) / 64 * 64;
+    auto *tri_buffers = (triangle_t *) malloc(sizeof(triangle_t) * LIST_BUFFER_SIZE * max_omp_threads);
+    auto *write_buffers = (uint8_t *) memalign(64, buf_stride * max_omp_threads);
+    for (auto tid = 0; tid < max_omp_threads; tid++) {
+        new(write_buffers + buf_stride * tid) BufT(tri_buffers + LIST_BUFFER_SIZE * tid, LIST_BUFFER_SIZE,
+                                                   make_flush(tid));
+    }
+    auto local_buffer = [write_buffers](int tid) {
+        return reinterpret_cast<BufT *>(write_buffers + buf_stride * tid);
+    };
+
+    auto tc_cnt = EnumerateTriBMPAndMergeDODG(g, max_omp_threads, [&](uint32_t u, row_ptr_t edge_idx, int cnt,
+                                                                       row_ptr_t *off_u_lst, row_ptr_t *) {
+        auto *buf = local_buffer(omp_get_thread_num());
+        auto v = g.adj[edge_idx];
+        for (auto i = 0; i < cnt; i++) {
+            buf->push(triangle_t{.u = static_cast<int32_t>(u), .v = v, .w = g.adj[off_u_lst[i]]});
+        }
+    });
+#pragma omp parallel for num_threads(max_omp_threads)
+    for (auto tid = 0; tid < max_omp_threads; tid++) {
+        local_buffer(tid)->submit_if_possible();
+    }
+    free(write_buffers);
+    free(tri_buffers);
+    log_info("Triangle Listing Time: %.3lf s", timer.elapsed());
+    return tc_cnt;
+}
+
+/*
+ * CountTriPerVertexDODG: local triangle counts (all three corners of a triangle get credit), in the new IDs.
+ * Thread-private uint8_t counters (flushed with an atomic add when full, as in EdgeListHistogram),
+ * merged into vertex_tc_cnt after the enumeration.
+ */
+inline size_t CountTriPerVertexDODG(graph_t &g, int max_omp_threads, size_t *&vertex_tc_cnt) {
+    Timer timer;
+    vertex_tc_cnt = (size_t *) malloc(sizeof(size_t) * g.n);
+    vector<uint8_t *> local_bufs(max_omp_threads);
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        local_bufs[omp_get_thread_num()] = (uint8_t *) calloc(g.n, sizeof(uint8_t));
+        MemSetOMP(vertex_tc_cnt, 0, g.n);
+    }
+
+    auto credit = [vertex_tc_cnt](uint8_t *local_buf, int32_t vid, int cnt) {
+        auto val = local_buf[vid] + cnt;
+        if (val >= 0xff) {
+            __sync_fetch_and_add(&vertex_tc_cnt[vid], val);
+            local_buf[vid] = 0;
+        } else {
+            local_buf[vid] = val;
+        }
+    };
+    auto tc_cnt = EnumerateTriBMPAndMergeDODG(g, max_omp_threads, [&](uint32_t u, row_ptr_t edge_idx, int cnt,
+                                                                       row_ptr_t *off_u_lst, row_ptr_t *) {
+        auto *local_buf = local_bufs[omp_get_thread_num()];
+        credit(local_buf, u, cnt);
+        credit(local_buf, g.adj[edge_idx], cnt);
+        for (auto i = 0; i < cnt; i++) {
+            credit(local_buf, g.adj[off_u_lst[i]], 1);
+        }
+    });
+
+    // Merge.
+#pragma omp parallel for num_threads(max_omp_threads) schedule(dynamic, 32*1024)
+    for (auto u = 0u; u < g.n; u++) {
+        for (auto *local_buf: local_bufs) {
+            vertex_tc_cnt[u] += local_buf[u];
+        }
+    }
+    for (auto *local_buf: local_bufs) {
+        free(local_buf);
+    }
+    log_info("Per-Vertex Triangle Counting Time: %.3lf s", timer.elapsed());
+    return tc_cnt;
+}
+
+/*
+ * CountTriPerEdgeDODG: edge support (#of triangles containing the edge), aligned with g.adj.
+ * (u, v) is credited once per edge, (u, w) and (v, w) once per triangle.
+ * The credits of the row of u ((u, v) and (u, w)) are gathered by the thread enumerating u and added (atomically,
+ * the row also gets the (v, w) credits of the other threads) once per edge when it moves to another u,
+ * only the (v, w) credits are atomic per triangle.
+ */
+inline size_t CountTriPerEdgeDODG(graph_t &g, int max_omp_threads, uint32_t *&edge_support) {
+    Timer timer;
+    edge_support = (uint32_t *) malloc(sizeof(uint32_t) * g.m);
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(edge_support, 0, g.m);
+    }
+
+    vector<vector<uint32_t>> row_credits(max_omp_threads);
+    vector<int64_t> credit_rows(max_omp_threads, -1);
+    auto flush_row = [&g, edge_support](int64_t u, vector<uint32_t> &credits) {
+        if (u < 0) {
+            return;
+        }
+        auto beg = g.row_ptrs[u];
+        for (row_ptr_t i = 0; i < g.row_ptrs[u + 1] - beg; i++) {
+            if (credits[i] != 0) {
+                __sync_fetch_and_add(&edge_support[beg + i], credits[i]);
+                credits[i] = 0;
+            }
+        }
+    };
+    auto tc_cnt = EnumerateTriBMPAndMergeDODG(g, max_omp_threads, [&](uint32_t u, row_ptr_t edge_idx, int cnt,
+                                                                       row_ptr_t *off_u_lst, row_ptr_t *off_v_lst) {
+        auto tid = omp_get_thread_num();
+        auto &credits = row_credits[tid];
+        if (credit_rows[tid] != u) {
+            flush_row(credit_rows[tid], credits);
+            credit_rows[tid] = u;
+            credits.resize(max<size_t>(credits.size(), g.row_ptrs[u + 1] - g.row_ptrs[u]), 0);
+        }
+        auto beg = g.row_ptrs[u];
+        credits[edge_idx - beg] += cnt;
+        for (auto i = 0; i < cnt; i++) {
+            credits[off_u_lst[i] - beg]++;
+            __sync_fetch_and_add(&edge_support[off_v_lst[i]], 1);
+        }
+    });
+    for (auto tid = 0; tid < max_omp_threads; tid++) {
+        flush_row(credit_rows[tid], row_credits[tid]);
+    }
+    log_info("Per-Edge Triangle Counting Time: %.3lf s", timer.elapsed());
+    return tc_cnt;
+}
+
 inline size_t CountTriBMPAndMergeWithPack(graph_t &g, int max_omp_threads) {
     Timer tc_timer;
     int max_d = 0;
@@ -139,11 +594,10 @@ inline size_t CountTriBMPAndMergeWithPack(graph_t &g, int max_omp_threads) {
     size_t workload_bmp = 0;
 
     using word_t = uint64_t;
-    constexpr int word_in_bits = sizeof(word_t) * 8;
 
     int to_pack_num = min<int>(g.n, MAX_PACK_NUM);
-    vector<vector<uint16_t>> word_indexes(to_pack_num);   // MAX_PACK_NUM * bits-sizeof(word)
-    vector<vector<word_t>> words(to_pack_num);
+    packed_words_t<uint16_t, word_t> packed{};     // MAX_PACK_NUM * bits-sizeof(word)
+    vector<size_t> histogram;
 
 #pragma omp parallel num_threads(max_omp_threads)
     {
@@ -161,18 +615,17 @@ inline size_t CountTriBMPAndMergeWithPack(graph_t &g, int max_omp_threads) {
             log_info("finish init row_ptrs_end, max d: %d, time: %.9lfs", max_d, tc_timer.elapsed());
         }
 
-        PackWords(g, row_ptrs_beg, to_pack_num, word_indexes, words, tc_timer);
+        PackWords(g, row_ptrs_beg, to_pack_num, packed, histogram, tc_timer);
 
 #pragma omp for schedule(dynamic, 100) reduction(+:tc_cnt) reduction(+:workload)  reduction(+:workload_large_deg) \
 reduction(+:workload_bmp)
         for (auto u = 0u; u < g.n; u++) {
             static thread_local BoolArray<word_t> bitmap(FIRST_RANGE_SIZE);
-            static thread_local vector<word_t> buffer(FIRST_RANGE_SIZE / word_in_bits);
             //  Index for First Range.
             if (g.row_ptrs[u] < row_ptrs_beg[u]) {
                 if (u < to_pack_num) {
-                    for (size_t i = 0; i < word_indexes[u].size(); i++) {
-                        bitmap.setWord(word_indexes[u][i], words[u][i]);
+                    for (auto i = packed.word_ptrs[u]; i < packed.word_ptrs[u + 1]; i++) {
+                        bitmap.setWord(packed.word_indexes[i], packed.words[i]);
                     }
                 } else {
                     for (auto off = g.row_ptrs[u]; off < row_ptrs_beg[u]; off++) {
@@ -189,19 +642,15 @@ reduction(+:workload_bmp)
                 // First Range.
                 if (g.row_ptrs[u] < row_ptrs_beg[u]) {
                     if (v < to_pack_num) {
-                        auto num_words_v = word_indexes[v].size();
-                        for (size_t i = 0; i < num_words_v; i++) {
+                        auto *word_indexes_v = packed.word_indexes + packed.word_ptrs[v];
+                        auto *words_v = packed.words + packed.word_ptrs[v];
+                        auto num_words_v = packed.word_ptrs[v + 1] - packed.word_ptrs[v];
 #ifdef WORKLOAD_STAT
-                            workload++;
-                            workload_bmp++;
-                            workload_large_deg++;
+                        workload += num_words_v;
+                        workload_bmp += num_words_v;
+                        workload_large_deg += num_words_v;
 #endif
-                            buffer[i] = bitmap.getWord(word_indexes[v][i]);
-                        }
-                        for (size_t i = 0; i < num_words_v; i++) {
-                            buffer[i] &= words[v][i];
-                        }
-                        cn_count += popcnt(&buffer.front(), sizeof(word_t) * num_words_v);
+                        cn_count += GatherAndPopcnt(bitmap.words(), word_indexes_v, words_v, num_words_v);
                     } else {
 #ifdef WORKLOAD_STAT
                         auto dv = row_ptrs_beg[v] - g.row_ptrs[v];
@@ -235,6 +684,7 @@ reduction(+:workload_bmp)
     }
     free(row_ptrs_beg);
     free(row_ptrs_end);
+    FreePackedWords(packed);
     log_info("Forward cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
     log_info("Triangle Cnt: %'zu", tc_cnt);
 #ifdef WORKLOAD_STAT
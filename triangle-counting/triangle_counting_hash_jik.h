@@ -0,0 +1,184 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/primitives.h"
+
+/*
+ * Hash-Map JIK Engine, ported from 2017-karypis-hepc-tc/ptc.c (ptc_MapJIK), on the DODG.
+ * For vj: hash N+(vj), for each in-neighbor vi (vi -> vj), probe the w in N+(vi) within [min, max] of N+(vj),
+ * each triangle (vi -> vj, vi -> w, vj -> w) is found once at vj. Unlike the Karypis' reordered graph, the ties of the
+ * DODG orientation (RankLT on the original IDs) do not follow the new IDs, hence the [min, max] window instead of
+ * the prefix w < vj.
+ * Phase 1: open-addressing hash map (16x the list size), for vj in [max_hm_size, n), in increasing degrees.
+ * Phase 2: for vj < max_hm_size, a direct map (0/1) if N+(vj) is in [0, max_hm_size), no map at all if N+(vj) is a
+ * contiguous ID range (the complete rows of ptc_MapJIK).
+ */
+#define JIK_SBSIZE (64)
+#define JIK_DBSIZE (8)
+#define JIK_EMPTY (-1)
+
+/*
+ * TransposeDODG: the in-neighbors (in_row_ptrs, in_adj), unsorted within a row.
+ */
+inline void TransposeDODG(graph_t &g, int max_omp_threads, row_ptr_t *&in_row_ptrs, int32_t *&in_adj) {
+    in_row_ptrs = (row_ptr_t *) malloc(sizeof(row_ptr_t) * (g.n + 1));
+    in_adj = (int32_t *) malloc(sizeof(int32_t) * max<long>(g.row_ptrs[g.n], 1));
+    auto *in_deg = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<long>(g.n, 1));
+    vector<size_t> histogram;
+    in_row_ptrs[0] = 0;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(in_deg, 0, g.n);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < g.n; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                __sync_fetch_and_add(&in_deg[g.adj[off]], 1);
+            }
+        }
+        InclusivePrefixSumOMP(histogram, in_row_ptrs + 1, g.n, [in_deg](size_t u) { return in_deg[u]; });
+        MemCpyOMP(in_deg, in_row_ptrs, g.n);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < g.n; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                in_adj[__sync_fetch_and_add(&in_deg[g.adj[off]], 1)] = u;
+            }
+        }
+    }
+    free(in_deg);
+}
+
+inline size_t CountTriHashJIKDODG(graph_t &g, int max_omp_threads) {
+    Timer tc_timer;
+    int64_t n = g.n;
+    row_ptr_t *in_row_ptrs;
+    int32_t *in_adj;
+    TransposeDODG(g, max_omp_threads, in_row_ptrs, in_adj);
+
+    int32_t max_d = 0;
+#pragma omp parallel for num_threads(max_omp_threads) reduction(max: max_d)
+    for (auto u = 0u; u < g.n; u++) {
+        max_d = max<int32_t>(max_d, g.row_ptrs[u + 1] - g.row_ptrs[u]);
+    }
+    // Compatible with a bitwise AND.
+    int32_t l2;
+    for (l2 = 1; max_d > (1 << l2); l2++);
+    int64_t max_hm_size = min<int64_t>((1 << (l2 + 4)) - 1, n);
+    log_info("Transpose Time: %.3lfs, max d: %d, max hash-map size: %lld", tc_timer.elapsed(), max_d, max_hm_size);
+
+    size_t tc_cnt = 0;
+    size_t num_probes = 0;
+    // Visits the w in N+(vi) within [lo, hi].
+    auto probe_window = [&g](int32_t vi, int32_t lo, int32_t hi, size_t &local_probes, auto f) {
+        row_ptr_t ei = lower_bound(g.adj + g.row_ptrs[vi], g.adj + g.row_ptrs[vi + 1], lo) - g.adj;
+        auto ei_beg = ei;
+        for (; ei < g.row_ptrs[vi + 1] && g.adj[ei] <= hi; ei++) {
+            f(g.adj[ei]);
+        }
+        local_probes += ei - ei_beg;
+    };
+#pragma omp parallel num_threads(max_omp_threads) reduction(+:tc_cnt, num_probes)
+    {
+        int32_t local_l2 = 1;
+        int32_t hm_size = (1 << (local_l2 + 4)) - 1;
+        vector<int32_t> hmap(1 << (l2 + 4), JIK_EMPTY);
+        vector<int32_t> dmap(max_hm_size, 0);
+
+        // Hash Map.
+        auto count_hash = [&](int64_t vj, size_t &local_cnt) {
+            auto dj = g.row_ptrs[vj + 1] - g.row_ptrs[vj];
+            // Adjust hm_size if needed.
+            if (dj > (1u << local_l2)) {
+                for (++local_l2; dj > (1u << local_l2); local_l2++);
+                hm_size = (1 << (local_l2 + 4)) - 1;
+            }
+
+            // Hash N+(vj).
+            int32_t num_collisions = 0;
+            for (auto ej = g.row_ptrs[vj]; ej < g.row_ptrs[vj + 1]; ej++) {
+                auto vk = g.adj[ej];
+                int32_t l;
+                for (l = vk & hm_size; hmap[l] != JIK_EMPTY; l = (l + 1) & hm_size, num_collisions++);
+                hmap[l] = vk;
+            }
+
+            // Find Intersections.
+            auto lo = g.adj[g.row_ptrs[vj]], hi = g.adj[g.row_ptrs[vj + 1] - 1];
+            for (auto ej = in_row_ptrs[vj]; ej < in_row_ptrs[vj + 1]; ej++) {
+                if (num_collisions > 0) {
+                    probe_window(in_adj[ej], lo, hi, num_probes, [&](int32_t vk) {
+                        int32_t l;
+                        for (l = vk & hm_size; hmap[l] != JIK_EMPTY && hmap[l] != vk; l = (l + 1) & hm_size);
+                        local_cnt += hmap[l] == vk;
+                    });
+                } else {
+                    probe_window(in_adj[ej], lo, hi, num_probes, [&](int32_t vk) {
+                        local_cnt += hmap[vk & hm_size] == vk;
+                    });
+                }
+            }
+
+            // Reset the Hash Map.
+            for (auto ej = g.row_ptrs[vj]; ej < g.row_ptrs[vj + 1]; ej++) {
+                auto vk = g.adj[ej];
+                int32_t l;
+                for (l = vk & hm_size; hmap[l] != vk; l = (l + 1) & hm_size);
+                hmap[l] = JIK_EMPTY;
+            }
+        };
+
+        // Phase 1: Hash Map.
+#pragma omp for schedule(dynamic, JIK_SBSIZE) nowait
+        for (int64_t vj = n - 1; vj >= max_hm_size; vj--) {
+            if (g.row_ptrs[vj] == g.row_ptrs[vj + 1] || in_row_ptrs[vj] == in_row_ptrs[vj + 1]) {
+                continue;
+            }
+            size_t local_cnt = 0;
+            count_hash(vj, local_cnt);
+            tc_cnt += local_cnt;
+        }
+
+        // Phase 2: Direct Map.
+#pragma omp for schedule(dynamic, JIK_DBSIZE) nowait
+        for (int64_t vj = max_hm_size - 1; vj >= 0; vj--) {
+            auto dj = g.row_ptrs[vj + 1] - g.row_ptrs[vj];
+            if (dj == 0 || in_row_ptrs[vj] == in_row_ptrs[vj + 1]) {
+                continue;
+            }
+            size_t local_cnt = 0;
+            auto lo = g.adj[g.row_ptrs[vj]], hi = g.adj[g.row_ptrs[vj + 1] - 1];
+            if (static_cast<row_ptr_t>(hi - lo + 1) == dj) {
+                // Complete Row: N+(vj) = [lo, hi].
+                for (auto ej = in_row_ptrs[vj]; ej < in_row_ptrs[vj + 1]; ej++) {
+                    probe_window(in_adj[ej], lo, hi, num_probes, [&](int32_t) { local_cnt++; });
+                }
+            } else if (hi < max_hm_size) {
+                for (auto ej = g.row_ptrs[vj]; ej < g.row_ptrs[vj + 1]; ej++) {
+                    dmap[g.adj[ej]] = 1;
+                }
+                for (auto ej = in_row_ptrs[vj]; ej < in_row_ptrs[vj + 1]; ej++) {
+                    probe_window(in_adj[ej], lo, hi, num_probes, [&](int32_t vk) { local_cnt += dmap[vk]; });
+                }
+                for (auto ej = g.row_ptrs[vj]; ej < g.row_ptrs[vj + 1]; ej++) {
+                    dmap[g.adj[ej]] = 0;
+                }
+            } else {
+                count_hash(vj, local_cnt);
+            }
+            tc_cnt += local_cnt;
+        }
+    }
+    free(in_row_ptrs);
+    free(in_adj);
+    log_info("Hash-JIK cost: %.3lf s, probes: %'zu, Mem Usage: %d KB", tc_timer.elapsed(), num_probes, getValue());
+    log_info("Triangle Cnt: %'zu", tc_cnt);
+    return tc_cnt;
+}
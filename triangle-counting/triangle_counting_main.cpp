@@ -18,7 +18,19 @@
 
 #include "pre_processing.h"
 #include "pre_processing_dodg.h"
+#include "pre_processing_external.h"
 #include "triangle_counting.h"
+#include "approx_triangle_counting.h"
+#include "triangle_counting_hash_jik.h"
+#include "triangle_counting_roaring.h"
+#include "triangle_counting_tiled.h"
+#include "triangle_counting_spgemm.h"
+#include "k_clique_counting.h"
+#include "clustering_coefficient.h"
+#include "truss_decomposition.h"
+#include "dynamic_triangle_counting.h"
+#include "streaming_triangle_counting.h"
+#include "pipeline_planner.h"
 
 using namespace std;
 using namespace popl;
@@ -31,7 +43,48 @@ using namespace std::chrono;
 int main(int argc, char *argv[]) {
     OptionParser op("Allowed options");
     auto string_option = op.add<Value<std::string>>("f", "file-path", "the graph bin file path");
+    auto vertex_tc_option = op.add<Value<std::string>>("", "vertex-tc",
+                                                       "output the per-vertex triangle counts (uint64, original IDs)");
+    auto edge_support_option = op.add<Value<std::string>>("", "edge-support",
+                                                          "output the per-edge support (uint32, aligned with the DODG "
+                                                          "adj), and the edges (original IDs) to <path>.el");
+    auto truss_option = op.add<Value<std::string>>("", "truss", "output the per-edge trussness (uint32, aligned with "
+                                                                "the DODG adj), and the edges (original IDs) to <path>.el");
+    auto clustering_option = op.add<Value<std::string>>("", "clustering", "output the local clustering coefficients "
+                                                                          "(float, original IDs), log the transitivity");
+    auto mem_budget_option = op.add<Value<size_t>>("", "mem-budget", "pre-process out of core, with at most these "
+                                                                     "MB of edges in memory (default: 0, in memory)",
+                                                   0);
+    auto pipeline_option = op.add<Value<std::string>>("", "pipeline", "the pre-processing pipeline: "
+                                                                      "auto|in-memory|spill|external", "auto");
+    auto spill_dir_option = op.add<Value<std::string>>("", "spill-dir", "the directory of the spilled files", ".");
+    auto sort_free_option = op.add<Switch>("", "sort-free", "build the DODG CSR without the global sort of the edge "
+                                                            "list (per-row sort and deduplication, in-memory only)");
+    auto simd_option = op.add<Value<std::string>>("", "simd", "force the SIMD variant: scalar|sse4|avx2|avx512 "
+                                                              "(default: detected by CPUID)");
+    auto list_option = op.add<Value<std::string>>("", "list", "list the triangles (int32 triples, original IDs), "
+                                                              "sharded per thread to <path>.<tid>");
+    auto sched_option = op.add<Value<std::string>>("", "sched", "the scheduling of the counting loop: "
+                                                                "dynamic|balanced|steal (default: balanced)");
+    auto engine_option = op.add<Value<std::string>>("", "engine", "the counting engine: "
+                                                                  "bmp-merge|hash-jik|roaring|tiled|spgemm "
+                                                                  "(default: bmp-merge)");
+    auto k_clique_option = op.add<Value<int>>("", "k-clique", "count the k-cliques instead (k >= 3)");
+    auto batch_option = op.add<Value<std::string>>("", "batch", "apply the batch of edge updates (int32 triples "
+                                                                "u, v, op: 0 insert, 1 delete, original IDs) after "
+                                                                "the count, repeatable");
+    auto approx_option = op.add<Value<std::string>>("", "approx", "estimate the count instead: edge|color|wedge "
+                                                                  "(edge sampling, coloring, wedge sampling)");
+    auto approx_error_option = op.add<Value<double>>("", "approx-error", "target relative half-width of the 95% CI",
+                                                     0.01);
+    auto approx_budget_option = op.add<Value<size_t>>("", "approx-budget", "at most these many edges kept "
+                                                                           "(edge|color) or wedges sampled (wedge)", 0);
+    auto approx_seed_option = op.add<Value<uint64_t>>("", "approx-seed", "the seed of the sampling", 0);
+    auto stream_option = op.add<Switch>("", "stream", "estimate the count in one pass over the file instead, "
+                                                      "from the edges kept under --stream-mem (seed: --approx-seed)");
+    auto stream_mem_option = op.add<Value<size_t>>("", "stream-mem", "the memory budget of --stream (MB)", 1024);
     op.parse(argc, argv);
+    InitSIMDKind(simd_option->is_set() ? simd_option->value(0) : "");
 
     using Edge = pair<int32_t, int32_t>;
     Timer global_timer;
@@ -44,64 +97,178 @@ int main(int argc, char *argv[]) {
         log_info("File size: %zu", size);
         log_info("#of Edges: %zu", num_edges);
 
-        // Load Bin File (DIO).
         auto file_name = string_option->value(0);
-        auto file_fd = open(file_name.c_str(), O_RDONLY | O_DIRECT, S_IRUSR | S_IWUSR);
-        Edge *edge_lst = (Edge *) memalign(PAGE_SIZE, size + IO_REQ_SIZE);
         auto max_omp_threads = omp_get_max_threads();
-        Timer io_timer;
-        size_t read_size = 0;
-#pragma omp parallel num_threads(IO_QUEUE_DEPTH)
-        {
-#pragma omp for schedule(dynamic, 1) reduction(+:read_size)
-            for (size_t i = 0; i < size; i += IO_REQ_SIZE) {
-                auto it_beg = i;
-                auto *chars = reinterpret_cast<uint8_t *>(edge_lst);
-                auto ret = pread(file_fd, chars + it_beg, IO_REQ_SIZE, it_beg);
-                if (ret != IO_REQ_SIZE) {
-                    log_error("Err, %zu, %zu, %zu, %d", i, it_beg, IO_REQ_SIZE, ret);
-                } else {
-                    read_size += ret;
-                }
+        Edge *edge_lst = nullptr;
+        double stream_rate = 1;
+        uint32_t num_vertices = 0;
+        graph_t g{.n=0, .m = 0, .adj=nullptr, .row_ptrs=nullptr};
+        uint32_t *deg_lst;
+
+        // 0th: Pipeline Selection, from the projected peaks against the memory limit (before loading anything).
+        auto spill_dir = ResolveSpillDir(spill_dir_option->value());
+        auto pipeline = PIPELINE_SPILL;
+        size_t ext_budget = mem_budget_option->value() * 1024 * 1024;
+        size_t sampled_num_vertices = 0;
+        if (!stream_option->is_set()) {
+            string limit_source;
+            auto mem_limit = GetEffectiveMemLimit(limit_source);
+            sampled_num_vertices = SampleMaxVertexId(file_name.c_str(), 16, 1024 * 1024) + 1ull;
+            auto plan = PlanPipeline(num_edges, sampled_num_vertices, mem_limit, max_omp_threads,
+                                     sort_free_option->is_set());
+            bool forced = ext_budget > 0 || pipeline_option->value() != "auto";
+            if (ext_budget > 0) {
+                plan.mode = PIPELINE_EXTERNAL;
+                plan.ext_budget = ext_budget;
+            } else if (forced) {
+                plan.mode = ParsePipelineMode(pipeline_option->value());
             }
-#pragma omp single
-            log_info("%zu, %zu", read_size, size);
+            if (spill_dir.empty() && plan.mode != PIPELINE_IN_MEMORY) {
+                log_warn("No writable spill directory, use %s", PipelineModeName(PIPELINE_IN_MEMORY));
+                plan.mode = PIPELINE_IN_MEMORY;
+            }
+            plan.peak = *max_element(plan.phase_peaks[plan.mode], plan.phase_peaks[plan.mode] + PHASE_NUM);
+            LogPipelinePlan(plan, limit_source.c_str(), forced);
+            pipeline = plan.mode;
+            ext_budget = plan.ext_budget;
+        } else if (spill_dir.empty()) {
+            pipeline = PIPELINE_IN_MEMORY;
         }
-        log_info("IO Time: %.6lfs, DIO-QPS: %.6lf GB/s", io_timer.elapsed(), size / io_timer.elapsed() / pow(1024, 3));
-        log_info("Load File Time: %.9lfs", global_timer.elapsed());
 
-        // 1st: Remove Multi-Edges and Self-Loops.
-        Timer sort_timer;
-        int32_t max_node_id = 0;
-#pragma omp parallel for reduction(max: max_node_id) schedule(dynamic, 32*1024)
-        for (size_t i = 0u; i < num_edges; i++) {
-            if (edge_lst[i].first > edge_lst[i].second) {
-                swap(edge_lst[i].first, edge_lst[i].second);
-            }
-            max_node_id = max(max_node_id, max(edge_lst[i].first, edge_lst[i].second));
+        bool sort_free = sort_free_option->is_set() && pipeline == PIPELINE_IN_MEMORY;
+        if (sort_free_option->is_set() && !sort_free) {
+            log_warn("--sort-free is ignored by the %s pipeline", PipelineModeName(pipeline));
         }
-        log_info("Populate File Time: %.9lfs", global_timer.elapsed());
-        // In-Place Parallel Sort.
-        ips4o::parallel::sort(edge_lst, edge_lst + num_edges, [](Edge l, Edge r) {
-            if (l.first == r.first) {
-                return l.second < r.second;
+
+        if (pipeline == PIPELINE_EXTERNAL) {
+            // 1st and 2nd, External-Memory: sorted runs of the budget, merged and scattered from the disk.
+            ConvertEdgeFileToDODGCSRExternal(file_name.c_str(), ext_budget, spill_dir.c_str(),
+                                             max_omp_threads, num_vertices, deg_lst, g.row_ptrs, g.adj);
+            g.n = num_vertices;
+        } else {
+            int32_t max_node_id = 0;
+            // The degrees with the multi-edges, counted by the loader for the sort-free conversion (nullptr: none, or
+            // an ID beyond the sampled #vertices, then counted by the conversion).
+            uint32_t *edge_deg_lst = nullptr;
+            if (stream_option->is_set()) {
+                // Streaming: only the kept edges are loaded, the pipeline below runs on them.
+                auto budget = stream_mem_option->value() * 1024 * 1024 / STREAM_BYTES_PER_EDGE;
+                edge_lst = StreamSampleEdgeFile(file_name.c_str(), IO_QUEUE_DEPTH, budget, approx_seed_option->value(),
+                                                num_edges, stream_rate);
+                size = num_edges * sizeof(Edge);
+#pragma omp parallel for reduction(max: max_node_id) schedule(dynamic, 32*1024)
+                for (size_t i = 0u; i < num_edges; i++) {
+                    max_node_id = max(max_node_id, edge_lst[i].second);
+                }
+            } else {
+                // Load Bin File (DIO), fused with the per-edge pass: each request is normalized (u <= v), reduced to
+                // the max ID and counted in the degrees by the thread that read it, while it is still in the cache.
+                auto file_fd = open(file_name.c_str(), O_RDONLY | O_DIRECT, S_IRUSR | S_IWUSR);
+                edge_lst = (Edge *) memalign(PAGE_SIZE, size + IO_REQ_SIZE);
+                size_t deg_capacity = sampled_num_vertices;
+                if (sort_free && deg_capacity > 0) {
+                    edge_deg_lst = (uint32_t *) calloc(deg_capacity + 1, sizeof(uint32_t));
+                }
+                bool deg_overflow = false;
+                Timer io_timer;
+                size_t read_size = 0;
+#pragma omp parallel num_threads(IO_QUEUE_DEPTH)
+                {
+#pragma omp for schedule(dynamic, 1) reduction(+:read_size) reduction(max: max_node_id) reduction(||: deg_overflow)
+                    for (size_t i = 0; i < size; i += IO_REQ_SIZE) {
+                        auto it_beg = i;
+                        auto *chars = reinterpret_cast<uint8_t *>(edge_lst);
+                        auto ret = pread(file_fd, chars + it_beg, IO_REQ_SIZE, it_beg);
+                        if (ret != IO_REQ_SIZE) {
+                            log_error("Err, %zu, %zu, %zu, %d", i, it_beg, IO_REQ_SIZE, ret);
+                        } else {
+                            read_size += ret;
+                        }
+                        if (ret <= 0) {
+                            continue;
+                        }
+                        auto it_end = min<size_t>(it_beg + ret, size) / sizeof(Edge);
+                        for (auto j = it_beg / sizeof(Edge); j < it_end; j++) {
+                            auto &e = edge_lst[j];
+                            if (e.first > e.second) {
+                                swap(e.first, e.second);
+                            }
+                            max_node_id = max(max_node_id, e.second);
+                            if (edge_deg_lst != nullptr && e.first != e.second) {
+                                if (static_cast<uint32_t>(e.second) < deg_capacity) {
+                                    __sync_fetch_and_add(&edge_deg_lst[e.first], 1);
+                                    __sync_fetch_and_add(&edge_deg_lst[e.second], 1);
+                                } else {
+                                    deg_overflow = true;
+                                }
+                            }
+                        }
+                    }
+#pragma omp single
+                    log_info("%zu, %zu", read_size, size);
+                }
+                log_info("IO Time: %.6lfs, DIO-QPS: %.6lf GB/s", io_timer.elapsed(),
+                         size / io_timer.elapsed() / pow(1024, 3));
+                if (deg_overflow) {
+                    log_info("Max ID %d beyond the sampled #vertices %zu, the degrees are counted again",
+                             max_node_id, deg_capacity);
+                    free(edge_deg_lst);
+                    edge_deg_lst = nullptr;
+                }
             }
-            return l.first < r.first;
-        });
-        log_info("Sort Time: %.9lfs", sort_timer.elapsed());
-        auto num_vertices = static_cast<uint32_t >(max_node_id) + 1;
-        log_info("Pre-Process Edge List Time: %.9lf s", global_timer.elapsed());
-
-        // 2nd: Convert Edge List to CSR.
-        graph_t g{.n=num_vertices, .m = 0, .adj=nullptr, .row_ptrs=nullptr};
-        uint32_t *deg_lst;
-        g.adj = nullptr;
+            log_info("Load File Time: %.9lfs", global_timer.elapsed());
 
-        ConvertEdgeListToDODGCSR(num_edges, edge_lst, num_vertices, deg_lst, g.row_ptrs, g.adj,
-                                 max_omp_threads, [&](size_t it) {
-                    return !(edge_lst[it].first == edge_lst[it].second
-                             || (it > 0 && edge_lst[it - 1] == edge_lst[it]));
+            // 1st: Remove Multi-Edges and Self-Loops.
+            Timer sort_timer;
+            if (sort_free) {
+                // Sort-Free: the self-loops and multi-edges are removed per row by the conversion below.
+            } else if (pipeline == PIPELINE_IN_MEMORY) {
+                // Parallel LSD Radix Sort of the packed keys (u << bits | v, u <= v), with one extra buffer.
+                int bits = max_node_id == 0 ? 1 : 32 - __builtin_clz(max_node_id);
+                auto *keys = (uint64_t *) malloc(sizeof(uint64_t) * max<size_t>(num_edges, 1));
+                auto *buf = reinterpret_cast<uint64_t *>(edge_lst);
+                vector<size_t> histogram;
+#pragma omp parallel
+                {
+#pragma omp for
+                    for (size_t i = 0u; i < num_edges; i++) {
+                        keys[i] = (static_cast<uint64_t>(edge_lst[i].first) << bits) | edge_lst[i].second;
+                    }
+                    RadixSortOMP(histogram, keys, buf, num_edges, 2 * bits);
+#pragma omp for
+                    for (size_t i = 0u; i < num_edges; i++) {
+                        auto key = keys[i];
+                        edge_lst[i] = make_pair(static_cast<int32_t>(key >> bits),
+                                                static_cast<int32_t>(key & ((1ull << bits) - 1)));
+                    }
+                }
+                free(reinterpret_cast<Edge *>(keys) == edge_lst ? buf : keys);
+            } else {
+                // In-Place Parallel Sort.
+                ips4o::parallel::sort(edge_lst, edge_lst + num_edges, [](Edge l, Edge r) {
+                    if (l.first == r.first) {
+                        return l.second < r.second;
+                    }
+                    return l.first < r.first;
                 });
+            }
+            log_info("Sort Time: %.9lfs", sort_timer.elapsed());
+            num_vertices = static_cast<uint32_t >(max_node_id) + 1;
+            log_info("Pre-Process Edge List Time: %.9lf s", global_timer.elapsed());
+
+            // 2nd: Convert Edge List to CSR.
+            g.n = num_vertices;
+            if (sort_free) {
+                ConvertEdgeListToDODGCSRSortFree(num_edges, edge_lst, num_vertices, deg_lst, g.row_ptrs, g.adj,
+                                                 max_omp_threads, edge_deg_lst);
+            } else {
+                ConvertEdgeListToDODGCSR(num_edges, edge_lst, num_vertices, deg_lst, g.row_ptrs, g.adj,
+                                         max_omp_threads, [&](size_t it) {
+                            return !(edge_lst[it].first == edge_lst[it].second
+                                     || (it > 0 && edge_lst[it - 1] == edge_lst[it]));
+                        }, pipeline == PIPELINE_SPILL ? (spill_dir + "/tmp_el.bin").c_str() : nullptr);
+            }
+        }
         g.m = g.row_ptrs[num_vertices];
         log_info("Undirected Graph G = (|V|, |E|): %lld, %lld", g.n, g.m);
         log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
@@ -109,18 +276,137 @@ int main(int argc, char *argv[]) {
         // 3rd: Reordering.
         vector<int32_t> new_dict;
         vector<int32_t> old_dict;
-        munmap(edge_lst, size);
+        if (edge_lst != nullptr) {
+            if (pipeline == PIPELINE_SPILL) {
+                munmap(edge_lst, size);
+            } else {
+                free(edge_lst);
+            }
+        }
 
-        auto *tmp_mem_blocks = (int32_t *) malloc(size / 2);
+        auto *tmp_mem_blocks = (int32_t *) malloc(sizeof(int32_t) * max<long>(g.m, 1));
         auto *org = g.adj;
         ReorderDegDescendingDODG(g, new_dict, old_dict, tmp_mem_blocks, deg_lst);
         free(org);
-        free(deg_lst);
 
         // 4th: Triangle Counting.
         log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
         size_t tc_cnt = 0;
-        tc_cnt = CountTriBMPAndMergeWithPackDODG(g, max_omp_threads);
+        // The Oriented Edges in the Original IDs, aligned with the DODG adj.
+        auto write_org_edges = [&g, &old_dict](const string &path) {
+            auto *org_edge_lst = (Edge *) malloc(sizeof(Edge) * g.m);
+#pragma omp parallel for schedule(dynamic, 100)
+            for (auto u = 0u; u < g.n; u++) {
+                for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                    org_edge_lst[off] = make_pair(old_dict[u], old_dict[g.adj[off]]);
+                }
+            }
+            WriteArrayToFile(path.c_str(), org_edge_lst, g.m);
+            free(org_edge_lst);
+        };
+        auto engine = engine_option->is_set() ? ParseTCEngine(engine_option->value(0)) : ENGINE_BMP_MERGE;
+        if (stream_option->is_set()) {
+            double pairs = 0;
+            auto result = EstimateTriSparsified(g, max_omp_threads, APPROX_EDGE, stream_rate, pairs);
+            auto std_dev = (result.ci_hi - result.estimate) / APPROX_Z;
+            log_info("Stream Estimate Time: %.9lfs", global_timer.elapsed());
+            printf("There are approximately %.0lf triangles in the input graph (variance: %.0lf, 95%% CI: "
+                   "[%.0lf, %.0lf]).\n", result.estimate, std_dev * std_dev, result.ci_lo, result.ci_hi);
+            return 0;
+        } else if (vertex_tc_option->is_set()) {
+            size_t *vertex_tc_cnt = nullptr;
+            tc_cnt = CountTriPerVertexDODG(g, max_omp_threads, vertex_tc_cnt);
+
+            // Map Back to the Original IDs.
+            auto *org_vertex_tc_cnt = (size_t *) malloc(sizeof(size_t) * g.n);
+#pragma omp parallel for
+            for (auto u = 0u; u < g.n; u++) {
+                org_vertex_tc_cnt[old_dict[u]] = vertex_tc_cnt[u];
+            }
+            WriteArrayToFile(vertex_tc_option->value(0).c_str(), org_vertex_tc_cnt, g.n);
+            log_info("Write Per-Vertex Triangle Counts Time: %.9lfs", global_timer.elapsed());
+            free(org_vertex_tc_cnt);
+            free(vertex_tc_cnt);
+        } else if (clustering_option->is_set()) {
+            float *local_cc = nullptr;
+            auto transitivity = ComputeClusteringDODG(g, max_omp_threads, deg_lst, old_dict, local_cc, tc_cnt);
+            WriteArrayToFile(clustering_option->value(0).c_str(), local_cc, g.n);
+            log_info("Write Local Clustering Coefficients Time: %.9lfs", global_timer.elapsed());
+            printf("The transitivity of the input graph is %.6lf.\n", transitivity);
+            free(local_cc);
+        } else if (edge_support_option->is_set()) {
+            uint32_t *edge_support = nullptr;
+            tc_cnt = CountTriPerEdgeDODG(g, max_omp_threads, edge_support);
+            WriteArrayToFile(edge_support_option->value(0).c_str(), edge_support, g.m);
+            free(edge_support);
+            write_org_edges(edge_support_option->value(0) + ".el");
+            log_info("Write Per-Edge Support Time: %.9lfs", global_timer.elapsed());
+        } else if (truss_option->is_set()) {
+            uint32_t *trussness = nullptr;
+            auto max_trussness = TrussDecompositionDODG(g, max_omp_threads, trussness, tc_cnt);
+            WriteArrayToFile(truss_option->value(0).c_str(), trussness, g.m);
+            free(trussness);
+            write_org_edges(truss_option->value(0) + ".el");
+            log_info("Write Per-Edge Trussness Time: %.9lfs", global_timer.elapsed());
+            printf("The max trussness of the input graph is %u.\n", max_trussness);
+        } else if (list_option->is_set()) {
+            vector<int> shard_fds(max_omp_threads);
+            vector<string> shard_paths(max_omp_threads);
+            for (auto tid = 0; tid < max_omp_threads; tid++) {
+                shard_paths[tid] = list_option->value(0) + "." + to_string(tid);
+                shard_fds[tid] = OpenFileForWrite(shard_paths[tid].c_str());
+            }
+            tc_cnt = ListTriDODG(g, max_omp_threads, [&](int tid, triangle_t *tri_lst, uint32_t size) {
+                for (auto i = 0u; i < size; i++) {
+                    tri_lst[i] = triangle_t{.u = old_dict[tri_lst[i].u], .v = old_dict[tri_lst[i].v],
+                            .w = old_dict[tri_lst[i].w]};
+                }
+                WriteArrayToFd(shard_fds[tid], tri_lst, size);
+            });
+            for (auto tid = 0; tid < max_omp_threads; tid++) {
+                CloseFileForWrite(shard_fds[tid], shard_paths[tid].c_str());
+            }
+            log_info("Write Triangle Shards Time: %.9lfs", global_timer.elapsed());
+        } else if (k_clique_option->is_set()) {
+            auto k = k_clique_option->value();
+            auto clique_cnt = CountKCliquesDODG(g, max_omp_threads, k);
+            printf("There are %zu %d-cliques in the input graph.\n", clique_cnt, max(k, 3));
+            return 0;
+        } else if (approx_option->is_set()) {
+            auto result = ApproxTriDODG(g, max_omp_threads, ParseApproxKind(approx_option->value(0)),
+                                        approx_error_option->value(), approx_budget_option->value(),
+                                        approx_seed_option->value());
+            printf("There are approximately %.0lf triangles in the input graph (95%% CI: [%.0lf, %.0lf]).\n",
+                   result.estimate, result.ci_lo, result.ci_hi);
+            return 0;
+        } else if (batch_option->is_set()) {
+            dynamic_graph_t dg;
+            BuildDynamicGraph(g, new_dict, CountTriBMPAndMergeWithPackDODG(g, max_omp_threads, SCHED_BALANCED),
+                              max_omp_threads, dg);
+            for (auto i = 0u; i < batch_option->count(); i++) {
+                size_t num_updates = 0;
+                auto *updates = ReadArrayFromFile<edge_update_t>(batch_option->value(i).c_str(), num_updates);
+                auto result = ApplyBatchDynamic(dg, updates, num_updates, max_omp_threads);
+                free(updates);
+                printf("After the batch %s, there are %zu triangles in the input graph (delta: %lld).\n",
+                       batch_option->value(i).c_str(), result.tc_cnt, static_cast<long long>(result.delta));
+            }
+            log_info("Dynamic Updates Time: %.9lfs", global_timer.elapsed());
+            tc_cnt = dg.tc_cnt;
+            FreeDynamicGraph(dg);
+        } else if (engine == ENGINE_HASH_JIK) {
+            tc_cnt = CountTriHashJIKDODG(g, max_omp_threads);
+        } else if (engine == ENGINE_ROARING) {
+            tc_cnt = CountTriRoaringDODG(g, max_omp_threads);
+        } else if (engine == ENGINE_TILED) {
+            tc_cnt = CountTriTiledDODG(g, max_omp_threads);
+        } else if (engine == ENGINE_SPGEMM) {
+            tc_cnt = CountTriSpGEMMDODG(g, max_omp_threads);
+        } else {
+            auto sched = sched_option->is_set() ? ParseTCSched(sched_option->value(0)) : SCHED_BALANCED;
+            tc_cnt = CountTriBMPAndMergeWithPackDODG(g, max_omp_threads, sched);
+        }
+        free(deg_lst);
         log_info("Mem Usage: %s KB", FormatWithCommas(getValue()).c_str());
         log_info("There are %zu triangles in the input graph.", tc_cnt);
         printf("There are %zu triangles in the input graph.\n", tc_cnt);
@@ -26,6 +26,7 @@ int main(int argc, char *argv[]) {
     OptionParser op("Allowed options");
     auto string_option = op.add<Value<std::string>>("f", "file-path", "the graph bin file path");
     op.parse(argc, argv);
+    InitSIMDKind();
 
     using Edge = pair<int32_t, int32_t>;
     Timer global_timer;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/roaring_index.h"
+
+/*
+ * Roaring Engine: N+(u) of every vertex (not only the first range of the bmp-merge engine) is indexed once
+ * (see BuildRoaringIndex), each out-edge (u, v) counts |N+(u) & N+(v)| container by container.
+ */
+inline size_t CountTriRoaringDODG(graph_t &g, int max_omp_threads) {
+    Timer tc_timer;
+    auto idx = BuildRoaringIndex(g, max_omp_threads);
+    tc_timer.reset();
+
+    size_t tc_cnt = 0;
+#pragma omp parallel for num_threads(max_omp_threads) schedule(dynamic, 100) reduction(+:tc_cnt)
+    for (auto u = 0u; u < g.n; u++) {
+        for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+            auto v = g.adj[off];
+            if (g.row_ptrs[v] != g.row_ptrs[v + 1]) {
+                tc_cnt += RoaringInterCnt(idx, u, v);
+            }
+        }
+    }
+    FreeRoaringIndex(idx);
+    log_info("Roaring Forward cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
+    log_info("Triangle Cnt: %'zu", tc_cnt);
+    return tc_cnt;
+}
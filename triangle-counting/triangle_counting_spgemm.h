@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+
+/*
+ * Masked SpGEMM Engine: the DODG as the strictly triangular L (row u: N+(u)), C = (L * L) .* L row by row,
+ * C[u][w] = |{v: u -> v, v -> w}| for w in N+(u), the count is sum(C). Only the entries in the mask are accumulated,
+ * the unmasked product is never materialized.
+ * Per-row accumulator, chosen by the flops (sum of d+(v)) against the span [min, max] of the mask:
+ * dense: a thread-local array over the span (w at w - min, grown on demand to the widest dense span of the thread;
+ * the mask is marked as 1, the counts are offset by 1),
+ * hash: open addressing over the mask (2x its size, power of 2), for the sparse rows whose span would miss the cache.
+ */
+#define SPGEMM_DENSE_SPAN_RATIO (16)
+#define SPGEMM_HASH_EMPTY (-1)
+
+enum spgemm_acc_t {
+    SPGEMM_ACC_DENSE = 0, SPGEMM_ACC_HASH = 1, SPGEMM_ACC_NUM = 2
+};
+
+/*
+ * MaskedSpGEMMDODG: f(u, vals), vals[i] = C[u][g.adj[g.row_ptrs[u] + i]], i in [0, d+(u)), for the rows with an entry.
+ * acc_rows: the rows per accumulator, flops: the multiply-adds (the w's visited).
+ */
+template<typename F>
+void MaskedSpGEMMDODG(graph_t &g, int max_omp_threads, F f, size_t *acc_rows, size_t &flops) {
+    size_t num_dense_rows = 0, num_hash_rows = 0, num_flops = 0;
+#pragma omp parallel num_threads(max_omp_threads) reduction(+:num_dense_rows, num_hash_rows, num_flops)
+    {
+        vector<uint32_t> dense_acc;
+        vector<int32_t> hash_keys;
+        vector<uint32_t> hash_vals;
+        vector<uint32_t> vals;
+#pragma omp for schedule(dynamic, 100)
+        for (auto u = 0u; u < g.n; u++) {
+            auto beg = g.row_ptrs[u], end = g.row_ptrs[u + 1];
+            if (end - beg < 2) {
+                continue;
+            }
+            auto du = end - beg;
+            size_t row_flops = 0;
+            for (auto off = beg; off < end; off++) {
+                auto v = g.adj[off];
+                row_flops += g.row_ptrs[v + 1] - g.row_ptrs[v];
+            }
+            if (row_flops == 0) {
+                continue;
+            }
+            num_flops += row_flops;
+            vals.resize(du);
+            auto lo = g.adj[beg], hi = g.adj[end - 1];
+            size_t span = hi - lo + 1;
+            if (row_flops * SPGEMM_DENSE_SPAN_RATIO >= span) {
+                num_dense_rows++;
+                if (dense_acc.size() < span) {
+                    dense_acc.resize(span, 0);
+                }
+                for (auto off = beg; off < end; off++) {
+                    dense_acc[g.adj[off] - lo] = 1;
+                }
+                for (auto off = beg; off < end; off++) {
+                    auto v = g.adj[off];
+                    // The sorted row of v, from its first w >= lo to its last w <= hi.
+                    row_ptr_t off_v = lower_bound(g.adj + g.row_ptrs[v], g.adj + g.row_ptrs[v + 1], lo) - g.adj;
+                    for (; off_v < g.row_ptrs[v + 1] && g.adj[off_v] <= hi; off_v++) {
+                        auto w = g.adj[off_v] - lo;
+                        dense_acc[w] += dense_acc[w] != 0;
+                    }
+                }
+                for (auto off = beg; off < end; off++) {
+                    vals[off - beg] = dense_acc[g.adj[off] - lo] - 1;
+                    dense_acc[g.adj[off] - lo] = 0;
+                }
+            } else {
+                num_hash_rows++;
+                uint32_t mask = 1;
+                for (; mask < 2 * du; mask <<= 1);
+                hash_keys.assign(mask, SPGEMM_HASH_EMPTY);
+                hash_vals.assign(mask, 0);
+                mask--;
+                for (auto off = beg; off < end; off++) {
+                    auto w = g.adj[off];
+                    uint32_t l;
+                    for (l = w & mask; hash_keys[l] != SPGEMM_HASH_EMPTY; l = (l + 1) & mask);
+                    hash_keys[l] = w;
+                }
+                for (auto off = beg; off < end; off++) {
+                    auto v = g.adj[off];
+                    for (auto off_v = g.row_ptrs[v]; off_v < g.row_ptrs[v + 1]; off_v++) {
+                        auto w = g.adj[off_v];
+                        if (w < lo || w > hi) {
+                            continue;
+                        }
+                        uint32_t l;
+                        for (l = w & mask; hash_keys[l] != SPGEMM_HASH_EMPTY && hash_keys[l] != w;
+                             l = (l + 1) & mask);
+                        hash_vals[l] += hash_keys[l] == w;
+                    }
+                }
+                for (auto off = beg; off < end; off++) {
+                    auto w = g.adj[off];
+                    uint32_t l;
+                    for (l = w & mask; hash_keys[l] != w; l = (l + 1) & mask);
+                    vals[off - beg] = hash_vals[l];
+                }
+            }
+            f(u, &vals.front());
+        }
+    }
+    acc_rows[SPGEMM_ACC_DENSE] = num_dense_rows;
+    acc_rows[SPGEMM_ACC_HASH] = num_hash_rows;
+    flops = num_flops;
+}
+
+inline size_t CountTriSpGEMMDODG(graph_t &g, int max_omp_threads) {
+    Timer tc_timer;
+    size_t tc_cnt = 0;
+    size_t acc_rows[SPGEMM_ACC_NUM] = {0};
+    size_t flops = 0;
+    MaskedSpGEMMDODG(g, max_omp_threads, [&g, &tc_cnt](uint32_t u, const uint32_t *vals) {
+        size_t row_cnt = 0;
+        for (auto i = 0u; i < g.row_ptrs[u + 1] - g.row_ptrs[u]; i++) {
+            row_cnt += vals[i];
+        }
+        __sync_fetch_and_add(&tc_cnt, row_cnt);
+    }, acc_rows, flops);
+    log_info("Masked SpGEMM, rows (dense/hash): %zu/%zu, flops: %zu", acc_rows[SPGEMM_ACC_DENSE],
+             acc_rows[SPGEMM_ACC_HASH], flops);
+    log_info("SpGEMM cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
+    log_info("Triangle Cnt: %'zu", tc_cnt);
+    return tc_cnt;
+}
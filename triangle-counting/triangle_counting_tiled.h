@@ -0,0 +1,161 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/set_inter_cnt_utils.h"
+#include "util/set_inter_adaptive.h"
+#include "util/dense_ranges.h"
+#include "util/chunk_scheduler.h"
+
+/*
+ * Tiled Engine: the v's are cut into tiles [tile_bounds[j], tile_bounds[j + 1]) whose out-neighbor lists fit in half
+ * of the L2, the out-edges (u, v) are bucketed per tile of v (ordered by u within a tile), and each task intersects
+ * a slice of the edges of one tile, so that N+(v) of the tile stays cache-resident across the many u's hitting it.
+ * Locality statistics: tile loads (a thread switching to a tile) and the N+(v) bytes they bring in, against the
+ * bytes of N+(v) read by the untiled loop (one list per edge).
+ */
+struct tile_edge_t {
+    int32_t u;
+    int32_t v;
+};
+
+struct tile_task_t {
+    uint32_t tile;
+    size_t edge_beg;
+    size_t edge_end;
+};
+
+inline size_t CountTriTiledDODG(graph_t &g, int max_omp_threads) {
+    Timer tc_timer;
+    auto m = g.row_ptrs[g.n];
+    size_t tile_adj_size = max<size_t>(GetCacheSize(2) / 2 / sizeof(int32_t), 1);
+    vector<uint32_t> tile_bounds{0};
+    while (tile_bounds.back() < g.n) {
+        auto target = g.row_ptrs[tile_bounds.back()] + tile_adj_size;
+        uint32_t bound = upper_bound(g.row_ptrs, g.row_ptrs + g.n + 1, target) - g.row_ptrs - 1;
+        tile_bounds.emplace_back(max(bound, tile_bounds.back() + 1));
+    }
+    uint32_t num_tiles = tile_bounds.size() - 1;
+    // The tile of v, and the out-edges bucketed per tile.
+    auto *tile_of = (uint32_t *) malloc(sizeof(uint32_t) * max<long>(g.n, 1));
+    auto *tile_edges = (tile_edge_t *) malloc(sizeof(tile_edge_t) * max<row_ptr_t>(m, 1));
+    // Tile-major: the edges of the thread tid into the tile j, at j * max_omp_threads + tid.
+    vector<size_t> tile_cnts(static_cast<size_t>(num_tiles) * max_omp_threads + 1, 0);
+    vector<tile_task_t> tasks;
+    auto cost_model = CalibrateSetInterCostModel(DENSE_RANGE_MIN_BITS);
+
+    size_t tc_cnt = 0;
+    size_t tile_loads = 0;
+    size_t tile_load_bytes = 0;
+    size_t untiled_bytes = 0;
+    size_t path_cnt[SET_INTER_PATH_NUM] = {0};
+    double tiling_time = 0;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+#pragma omp for schedule(dynamic, 16)
+        for (auto j = 0u; j < num_tiles; j++) {
+            for (auto v = tile_bounds[j]; v < tile_bounds[j + 1]; v++) {
+                tile_of[v] = j;
+            }
+        }
+        // Edge-balanced u ranges, in order, so that the edges of a tile are sorted by u.
+        auto tid = omp_get_thread_num();
+        auto num_threads = omp_get_num_threads();
+        auto u_range = [&](int t) -> uint32_t {
+            return lower_bound(g.row_ptrs, g.row_ptrs + g.n, m * t / num_threads) - g.row_ptrs;
+        };
+        uint32_t u_beg = u_range(tid), u_end = tid == num_threads - 1 ? g.n : u_range(tid + 1);
+        vector<size_t> local_cnts(num_tiles, 0);
+        for (auto u = u_beg; u < u_end; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                local_cnts[tile_of[g.adj[off]]]++;
+            }
+        }
+        for (auto j = 0u; j < num_tiles; j++) {
+            tile_cnts[static_cast<size_t>(j) * max_omp_threads + tid] = local_cnts[j];
+        }
+#pragma omp barrier
+#pragma omp single
+        {
+            size_t acc = 0;
+            for (auto &cnt: tile_cnts) {
+                auto tmp = cnt;
+                cnt = acc;
+                acc += tmp;
+            }
+            // Slices of about the work of a balanced chunk.
+            size_t task_edges = max<size_t>(1, m / (num_threads * CHUNKS_PER_THREAD));
+            for (auto j = 0u; j < num_tiles; j++) {
+                auto beg = tile_cnts[static_cast<size_t>(j) * max_omp_threads];
+                auto end = tile_cnts[static_cast<size_t>(j + 1) * max_omp_threads];
+                for (auto edge_beg = beg; edge_beg < end; edge_beg += task_edges) {
+                    tasks.emplace_back(tile_task_t{.tile = j, .edge_beg = edge_beg,
+                            .edge_end = min(end, edge_beg + task_edges)});
+                }
+            }
+        }
+        for (auto j = 0u; j < num_tiles; j++) {
+            local_cnts[j] = tile_cnts[static_cast<size_t>(j) * max_omp_threads + tid];
+        }
+        for (auto u = u_beg; u < u_end; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                auto v = g.adj[off];
+                tile_edges[local_cnts[tile_of[v]]++] = tile_edge_t{.u = static_cast<int32_t>(u), .v = v};
+            }
+        }
+#pragma omp barrier
+#pragma omp single
+        {
+            tiling_time = tc_timer.elapsed_and_reset();
+        }
+
+        int64_t last_tile = -1;
+#pragma omp for schedule(dynamic, 1) reduction(+:tc_cnt, tile_loads, tile_load_bytes, untiled_bytes) \
+reduction(+:path_cnt[:SET_INTER_PATH_NUM])
+        for (size_t t = 0; t < tasks.size(); t++) {
+            auto &task = tasks[t];
+            if (task.tile != last_tile) {
+                last_tile = task.tile;
+                tile_loads++;
+                tile_load_bytes += sizeof(int32_t) *
+                                   (g.row_ptrs[tile_bounds[task.tile + 1]] - g.row_ptrs[tile_bounds[task.tile]]);
+            }
+            for (auto e = task.edge_beg; e < task.edge_end; e++) {
+                auto u = tile_edges[e].u, v = tile_edges[e].v;
+                auto du = g.row_ptrs[u + 1] - g.row_ptrs[u];
+                auto dv = g.row_ptrs[v + 1] - g.row_ptrs[v];
+                untiled_bytes += sizeof(int32_t) * dv;
+                if (dv == 0) {
+                    continue;
+                }
+                auto path = SelectSetInterPath(cost_model, du, dv, false);
+                path_cnt[path]++;
+                if (path == SET_INTER_PATH_LOOKUP) {
+                    tc_cnt += SetInterLookup(&g, g.row_ptrs[u], g.row_ptrs[u + 1], g.row_ptrs[v], g.row_ptrs[v + 1]);
+                } else {
+                    tc_cnt += SetInterCntVecMerge(&g, g.row_ptrs[u], g.row_ptrs[u + 1], g.row_ptrs[v],
+                                                  g.row_ptrs[v + 1]);
+                }
+            }
+        }
+    }
+    free(tile_of);
+    free(tile_edges);
+    log_info("Tiling Time: %.3lfs, tiles: %u (N+(v) at most %zu KB), tasks: %zu", tiling_time, num_tiles,
+             tile_adj_size * sizeof(int32_t) / 1024, tasks.size());
+    log_info("Tile Locality, loads: %zu, edges per load: %.1lf, N+(v) bytes loaded: %zu KB vs untiled: %zu KB "
+             "(%.2lfx)", tile_loads, static_cast<double>(m) / max<size_t>(tile_loads, 1), tile_load_bytes / 1024,
+             untiled_bytes / 1024, static_cast<double>(untiled_bytes) / max<size_t>(tile_load_bytes, 1));
+    log_info("Intersection Paths, merge: %zu, lookup: %zu", path_cnt[SET_INTER_PATH_MERGE],
+             path_cnt[SET_INTER_PATH_LOOKUP]);
+    log_info("Tiled Forward cost: %.3lf s, Mem Usage: %d KB", tc_timer.elapsed(), getValue());
+    log_info("Triangle Cnt: %'zu", tc_cnt);
+    return tc_cnt;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "util/graph.h"
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/util.h"
+#include "util/primitives.h"
+#include "util/set_inter_emit_utils.h"
+#include "triangle_counting.h"
+
+/*
+ * k-Truss Decomposition (PKT-style peeling) of the DODG edges, trussness(e) = (the level of its peel) + 2.
+ * The support is from CountTriPerEdgeDODG, the triangles of an edge (u, v) are N(u) & N(v) of the undirected CSR
+ * (with the DODG edge IDs), emitted by the SIMD intersection.
+ * The edges are bucket-sorted by their initial support: the frontier of the level l (the remaining edges of support l)
+ * is selected among the edges of initial support >= l only, an empty level jumps to the minimum remaining support.
+ * A sub-level peels the frontier, the edges dropping to the support l form the next sub-level.
+ */
+inline uint32_t TrussDecompositionDODG(graph_t &g, int max_omp_threads, uint32_t *&trussness, size_t &tc_cnt) {
+    uint32_t *sup = nullptr;
+    tc_cnt = CountTriPerEdgeDODG(g, max_omp_threads, sup);
+    Timer timer;
+    row_ptr_t m = g.row_ptrs[g.n];
+    trussness = (uint32_t *) malloc(sizeof(uint32_t) * max<row_ptr_t>(m, 1));
+
+    // The undirected CSR, rows sorted, und_eid: the DODG edge of each entry.
+    graph_t und{.n = g.n, .m = static_cast<long>(2 * m), .adj = nullptr, .row_ptrs = nullptr};
+    und.row_ptrs = (row_ptr_t *) malloc(sizeof(row_ptr_t) * (g.n + 1));
+    und.adj = (int32_t *) malloc(sizeof(int32_t) * max<row_ptr_t>(2 * m, 1));
+    auto *und_eid = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(2 * m, 1));
+    auto *und_cursor = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<long>(g.n, 1));
+    auto *edge_src = (int32_t *) malloc(sizeof(int32_t) * max<row_ptr_t>(m, 1));
+    auto *edge_ids = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(m, 1));
+    auto *sorted_edges = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(m, 1));
+    auto *curr = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(m, 1));
+    auto *next = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(m, 1));
+    auto *relative_off = (row_ptr_t *) malloc(sizeof(row_ptr_t) * max<row_ptr_t>(m, 1));
+    auto *processed = (uint8_t *) calloc(max<row_ptr_t>(m, 1), sizeof(uint8_t));
+    auto *in_curr = (uint8_t *) calloc(max<row_ptr_t>(m, 1), sizeof(uint8_t));
+    row_ptr_t *bucket_ptrs = nullptr, *bucket_ends = nullptr;
+    vector<size_t> histogram;
+
+    uint32_t max_sup = 0;
+    int64_t max_und_d = 0;
+    uint32_t level = 0;
+    row_ptr_t todo = m, curr_size = 0, next_size = 0, scan_beg = 0;
+    uint32_t min_sup = 0;
+    size_t num_levels = 0, num_sub_levels = 0;
+    und.row_ptrs[0] = 0;
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        MemSetOMP(und_cursor, 0, g.n);
+#pragma omp for schedule(dynamic, 1024) reduction(max: max_sup)
+        for (auto u = 0u; u < g.n; u++) {
+            __sync_fetch_and_add(&und_cursor[u], g.row_ptrs[u + 1] - g.row_ptrs[u]);
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                __sync_fetch_and_add(&und_cursor[g.adj[off]], 1);
+                edge_src[off] = u;
+                edge_ids[off] = off;
+                max_sup = max(max_sup, sup[off]);
+            }
+        }
+        InclusivePrefixSumOMP(histogram, und.row_ptrs + 1, g.n, [und_cursor](size_t u) { return und_cursor[u]; });
+        MemCpyOMP(und_cursor, und.row_ptrs, g.n);
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < g.n; u++) {
+            for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+                auto v = g.adj[off];
+                auto pos_u = __sync_fetch_and_add(&und_cursor[u], 1);
+                und.adj[pos_u] = v;
+                und_eid[pos_u] = off;
+                auto pos_v = __sync_fetch_and_add(&und_cursor[v], 1);
+                und.adj[pos_v] = u;
+                und_eid[pos_v] = off;
+            }
+        }
+        vector<pair<int32_t, row_ptr_t>> row;
+#pragma omp for schedule(dynamic, 1024) reduction(max: max_und_d)
+        for (auto u = 0u; u < g.n; u++) {
+            auto beg = und.row_ptrs[u], end = und.row_ptrs[u + 1];
+            max_und_d = max<int64_t>(max_und_d, end - beg);
+            row.clear();
+            for (auto off = beg; off < end; off++) {
+                row.emplace_back(und.adj[off], und_eid[off]);
+            }
+            sort(row.begin(), row.end());
+            for (auto off = beg; off < end; off++) {
+                und.adj[off] = row[off - beg].first;
+                und_eid[off] = row[off - beg].second;
+            }
+        }
+
+        // bucket_ptrs[s]: the first edge of initial support s in sorted_edges.
+        BucketSort(histogram, edge_ids, sorted_edges, bucket_ends, bucket_ptrs, m, max_sup + 1,
+                   [sup](size_t e) { return sup[e]; });
+#pragma omp single
+        {
+            log_info("Truss Init Time: %.3lfs, max support: %u, max d: %lld", timer.elapsed(), max_sup, max_und_d);
+        }
+
+        vector<row_ptr_t> out_off_u(max<int64_t>(max_und_d, 1)), out_off_v(max<int64_t>(max_und_d, 1));
+        auto dec = [&](row_ptr_t e) {
+            auto s = __sync_fetch_and_sub(&sup[e], 1);
+            if (s == level + 1) {
+                next[__sync_fetch_and_add(&next_size, 1)] = e;
+            }
+            if (s <= level) {
+                __sync_fetch_and_add(&sup[e], 1);
+            }
+        };
+        while (todo > 0) {
+            // Frontier: the remaining edges of initial support >= level with the support level.
+#pragma omp single
+            {
+                scan_beg = bucket_ptrs[min(level, max_sup)];
+                min_sup = UINT32_MAX;
+            }
+            auto scan_size = m - scan_beg;
+            SelectNotFOMP(histogram, curr, sorted_edges + scan_beg, relative_off, scan_size, [&](size_t i) {
+                auto e = sorted_edges[scan_beg + i];
+                return processed[e] || sup[e] != level;
+            });
+#pragma omp single
+            {
+                curr_size = scan_size - (scan_size > 0 ? relative_off[scan_size - 1] : 0);
+            }
+            if (curr_size == 0) {
+#pragma omp for reduction(min: min_sup)
+                for (row_ptr_t i = scan_beg; i < m; i++) {
+                    auto e = sorted_edges[i];
+                    if (!processed[e]) {
+                        min_sup = min(min_sup, sup[e]);
+                    }
+                }
+#pragma omp single
+                {
+                    level = min_sup;
+                }
+                continue;
+            }
+            while (curr_size > 0) {
+#pragma omp for
+                for (row_ptr_t i = 0; i < curr_size; i++) {
+                    in_curr[curr[i]] = 1;
+                }
+#pragma omp for schedule(dynamic, 4)
+                for (row_ptr_t i = 0; i < curr_size; i++) {
+                    auto e = curr[i];
+                    auto u = edge_src[e], v = g.adj[e];
+                    auto num = SetInterEmitVecMerge(&und, und.row_ptrs[u], und.row_ptrs[u + 1], und.row_ptrs[v],
+                                                    und.row_ptrs[v + 1], &out_off_u.front(), &out_off_v.front());
+                    for (auto j = 0; j < num; j++) {
+                        auto e1 = und_eid[out_off_u[j]], e2 = und_eid[out_off_v[j]];
+                        if (processed[e1] || processed[e2]) {
+                            continue;
+                        }
+                        // An edge of the frontier decrements the other one only once, from the smaller edge ID.
+                        if (sup[e1] > level && sup[e2] > level) {
+                            dec(e1);
+                            dec(e2);
+                        } else if (sup[e1] > level) {
+                            if (!in_curr[e2] || e < e2) {
+                                dec(e1);
+                            }
+                        } else if (sup[e2] > level) {
+                            if (!in_curr[e1] || e < e1) {
+                                dec(e2);
+                            }
+                        }
+                    }
+                }
+#pragma omp for
+                for (row_ptr_t i = 0; i < curr_size; i++) {
+                    auto e = curr[i];
+                    processed[e] = 1;
+                    in_curr[e] = 0;
+                    trussness[e] = level + 2;
+                }
+#pragma omp single
+                {
+                    todo -= curr_size;
+                    swap(curr, next);
+                    curr_size = next_size;
+                    next_size = 0;
+                    num_sub_levels++;
+                }
+            }
+#pragma omp single
+            {
+                level++;
+                num_levels++;
+            }
+        }
+    }
+    log_info("Truss Peeling Time: %.3lfs, levels: %zu, sub-levels: %zu, max trussness: %u", timer.elapsed(),
+             num_levels, num_sub_levels, m > 0 ? level + 1 : 0);
+    free(sup);
+    free(und.row_ptrs);
+    free(und.adj);
+    free(und_eid);
+    free(und_cursor);
+    free(edge_src);
+    free(edge_ids);
+    free(sorted_edges);
+    free(curr);
+    free(next);
+    free(relative_off);
+    free(processed);
+    free(in_curr);
+    free(bucket_ptrs);
+    free(bucket_ends);
+    return m > 0 ? level + 1 : 0;
+}
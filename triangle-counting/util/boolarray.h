@@ -162,6 +162,8 @@ public:
         return buffer[pos];
     }
 
+    const uword *words() const { return buffer.data(); }
+
     /**
      * set to true (whether it was already set to true or not)
      */
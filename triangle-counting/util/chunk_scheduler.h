@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "graph.h"
+#include "log.h"
+#include "primitives.h"
+
+/*
+ * Scheduling of the forward loop over u:
+ * dynamic: OpenMP schedule(dynamic, 100) over the vertex IDs.
+ * balanced: the estimated cost of u, 1 + sum over v in N+(u) of (d+(u) + d+(v)), is prefix-summed and cut into
+ * chunks of equal work (CHUNKS_PER_THREAD per thread), handed out with a shared atomic cursor.
+ * steal: balanced, and the out-edges of a vertex above the work per chunk are split into OpenMP tasks of about the
+ * work per chunk, stolen by the idle threads (each with its own bitmap of u).
+ */
+#define CHUNKS_PER_THREAD (64)
+
+enum tc_sched_t {
+    SCHED_DYNAMIC = 0, SCHED_BALANCED = 1, SCHED_STEAL = 2
+};
+
+inline const char *TCSchedName(tc_sched_t sched) {
+    static const char *names[] = {"dynamic", "balanced", "steal"};
+    return names[sched];
+}
+
+inline tc_sched_t ParseTCSched(const std::string &name) {
+    for (auto it = SCHED_DYNAMIC; it <= SCHED_STEAL; it = static_cast<tc_sched_t>(it + 1)) {
+        if (name == TCSchedName(it)) {
+            return it;
+        }
+    }
+    log_warn("Unknown scheduler: %s, use %s", name.c_str(), TCSchedName(SCHED_BALANCED));
+    return SCHED_BALANCED;
+}
+
+/*
+ * BalancedChunksOMP: called inside a parallel region.
+ * work_prefix: n entries, chunk_bounds: chunk i is [chunk_bounds[i], chunk_bounds[i + 1]),
+ * a vertex with more than the average work per chunk ends up at the head of its own chunk.
+ */
+template<typename H>
+void BalancedChunksOMP(graph_t &g, vector<H> &histogram, size_t *work_prefix, vector<uint32_t> &chunk_bounds) {
+    InclusivePrefixSumOMP(histogram, work_prefix, g.n, [&g](size_t u) {
+        auto du = g.row_ptrs[u + 1] - g.row_ptrs[u];
+        size_t work = 1;
+        for (auto off = g.row_ptrs[u]; off < g.row_ptrs[u + 1]; off++) {
+            auto v = g.adj[off];
+            work += du + g.row_ptrs[v + 1] - g.row_ptrs[v];
+        }
+        return work;
+    });
+#pragma omp single
+    {
+        size_t num_chunks = omp_get_num_threads() * CHUNKS_PER_THREAD;
+        auto total_work = g.n > 0 ? work_prefix[g.n - 1] : 0;
+        chunk_bounds.clear();
+        chunk_bounds.emplace_back(0);
+        for (size_t i = 1; i < num_chunks; i++) {
+            auto target = total_work / num_chunks * i;
+            uint32_t bound = upper_bound(work_prefix, work_prefix + g.n, target) - work_prefix;
+            if (bound > chunk_bounds.back()) {
+                chunk_bounds.emplace_back(bound);
+            }
+        }
+        if (chunk_bounds.back() < g.n) {
+            chunk_bounds.emplace_back(g.n);
+        }
+        log_info("Balanced Chunks: %zu, total work: %zu, avg per chunk: %zu", chunk_bounds.size() - 1, total_work,
+                 total_work / num_chunks);
+    }
+}
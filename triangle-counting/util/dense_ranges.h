@@ -0,0 +1,114 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+#include "graph.h"
+#include "log.h"
+#include "timer.h"
+
+/*
+ * Dense Ranges: the vertex IDs (degree-descending) are split into [bounds[0], bounds[1]), ..., [bounds[k-1], n).
+ * The first k-1 ranges are probed with a bitmap, each sized to half of a cache level (L1d, L2, L3 per thread),
+ * the first one additionally packs the words of its vertices; the last range uses the merge.
+ * The bitmap ranges stop where the in-degree histogram drops below DENSE_RANGE_MIN_AVG_DEG.
+ */
+#define DENSE_RANGE_HIST_BLOCK (4096)
+#define DENSE_RANGE_MIN_AVG_DEG (2)
+#define DENSE_RANGE_MIN_BITS (4096)
+#define DENSE_RANGE_MAX_PACK_BITS (65536l * 64)   // uint16_t word indexes
+#define DENSE_RANGE_MAX_LEVELS (3)
+
+using namespace std;
+
+enum dense_range_kind_t {
+    RANGE_BITMAP_PACK = 0, RANGE_BITMAP = 1, RANGE_MERGE = 2
+};
+
+inline const char *DenseRangeKindName(dense_range_kind_t kind) {
+    static const char *names[] = {"bitmap+pack", "bitmap", "merge"};
+    return names[kind];
+}
+
+struct dense_range_plan_t {
+    vector<int32_t> bounds;     // size: number of ranges + 1, bounds.back() == n
+    int32_t max_bitmap_range;
+
+    int num_ranges() const { return bounds.size() - 1; }
+
+    dense_range_kind_t kind(int r) const {
+        return r == num_ranges() - 1 ? RANGE_MERGE : (r == 0 ? RANGE_BITMAP_PACK : RANGE_BITMAP);
+    }
+};
+
+// Data (or unified) cache size in bytes of the level (1, 2 or 3), with a default if the OS does not report it.
+inline long GetCacheSize(int level) {
+    static const int names[] = {_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE, _SC_LEVEL3_CACHE_SIZE};
+    static const long defaults[] = {32 * 1024, 1024 * 1024, 8 * 1024 * 1024};
+    auto size = sysconf(names[level - 1]);
+    return size > 0 ? size : defaults[level - 1];
+}
+
+inline dense_range_plan_t PlanDenseRanges(graph_t &g, int max_omp_threads) {
+    Timer timer;
+    auto num_blocks = (g.n + DENSE_RANGE_HIST_BLOCK - 1) / DENSE_RANGE_HIST_BLOCK;
+    vector<size_t> histogram(num_blocks);
+    auto m = g.row_ptrs[g.n];
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+        vector<size_t> local_histogram(num_blocks);
+#pragma omp for
+        for (row_ptr_t off = 0; off < m; off++) {
+            local_histogram[g.adj[off] / DENSE_RANGE_HIST_BLOCK]++;
+        }
+#pragma omp critical
+        for (auto b = 0; b < num_blocks; b++) {
+            histogram[b] += local_histogram[b];
+        }
+    }
+    long dense_end = g.n;
+    for (auto b = 0; b < num_blocks; b++) {
+        auto block_size = min<long>(DENSE_RANGE_HIST_BLOCK, g.n - b * DENSE_RANGE_HIST_BLOCK);
+        if (histogram[b] < static_cast<size_t>(DENSE_RANGE_MIN_AVG_DEG * block_size)) {
+            dense_end = b * DENSE_RANGE_HIST_BLOCK;
+            break;
+        }
+    }
+
+    dense_range_plan_t plan{.bounds={0}, .max_bitmap_range=0};
+    long lo = 0;
+    for (auto level = 1; level <= DENSE_RANGE_MAX_LEVELS && lo < dense_end; level++) {
+        auto cache_size = GetCacheSize(level) / (level == DENSE_RANGE_MAX_LEVELS ? max_omp_threads : 1);
+        long bits = cache_size * 8 / 2 / 64 * 64;
+        if (level == 1) {
+            bits = min(max<long>(bits, DENSE_RANGE_MIN_BITS), DENSE_RANGE_MAX_PACK_BITS);
+        }
+        long hi = min(dense_end, lo + bits);
+        if (level > 1 && hi - lo < DENSE_RANGE_MIN_BITS) {
+            break;
+        }
+        plan.bounds.emplace_back(hi);
+        plan.max_bitmap_range = max<int32_t>(plan.max_bitmap_range, hi - lo);
+        lo = hi;
+    }
+    // Tiny graphs: the first range covers the whole graph.
+    if (plan.bounds.size() == 1) {
+        plan.bounds.emplace_back(min<long>(g.n, DENSE_RANGE_MIN_BITS));
+        plan.max_bitmap_range = plan.bounds.back();
+    }
+    plan.bounds.emplace_back(g.n);
+
+    for (auto r = 0; r < plan.num_ranges(); r++) {
+        auto beg = plan.bounds[r], end = plan.bounds[r + 1];
+        log_info("Range %d: [%d, %d), %s, Deg at [%d, %d]", r, beg, end, DenseRangeKindName(plan.kind(r)),
+                 beg < end ? g.row_ptrs[beg + 1] - g.row_ptrs[beg] : 0,
+                 beg < end ? g.row_ptrs[end] - g.row_ptrs[end - 1] : 0);
+    }
+    log_info("Dense Ranges (L1d: %ld, L2: %ld, L3: %ld), dense end: %ld, time: %.6lfs", GetCacheSize(1),
+             GetCacheSize(2), GetCacheSize(3), dense_end, timer.elapsed());
+    return plan;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <x86intrin.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "libpopcnt.h"
+#include "simd_dispatch.h"
+
+/*
+ * Fused Gather-AND-Popcount: sum of popcount(bitmap[indexes[i]] & words[i]), i in [0, num_words),
+ * the gathered words stay in registers (no intermediate buffer).
+ * AVX2: 4 words per gather, AVX-512: 8 words per gather, both count the bits with the nibble lookup (vpshufb) and
+ * vpsadbw, the leftover words and the SSE4 variant use the popcnt instruction.
+ */
+inline uint32_t GatherAndPopcntScalar(const uint64_t *bitmap, const uint16_t *indexes, const uint64_t *words,
+                                      size_t num_words) {
+    uint64_t cnt = 0;
+    for (size_t i = 0; i < num_words; i++) {
+        cnt += popcount64(bitmap[indexes[i]] & words[i]);
+    }
+    return cnt;
+}
+
+SIMD_TARGET_SSE4
+inline uint32_t GatherAndPopcntSSE4(const uint64_t *bitmap, const uint16_t *indexes, const uint64_t *words,
+                                    size_t num_words) {
+    uint64_t cnt = 0;
+    for (size_t i = 0; i < num_words; i++) {
+        cnt += __builtin_popcountll(bitmap[indexes[i]] & words[i]);
+    }
+    return cnt;
+}
+
+// Per 64-bit lane popcount (in the low bits of each lane).
+SIMD_TARGET_AVX2
+inline __m256i PopcntEpi64AVX2(__m256i x) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    auto lo = _mm256_and_si256(x, low_mask);
+    auto hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+    auto cnt8 = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(cnt8, _mm256_setzero_si256());
+}
+
+SIMD_TARGET_AVX2
+inline uint64_t HorizontalSumEpi64AVX2(__m256i x) {
+    auto sum = _mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t GatherAndPopcntAVX2(const uint64_t *bitmap, const uint16_t *indexes, const uint64_t *words,
+                                    size_t num_words) {
+    auto acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= num_words; i += 4) {
+        uint64_t indexes4;
+        memcpy(&indexes4, indexes + i, sizeof(indexes4));
+        auto vindex = _mm_cvtepu16_epi32(_mm_cvtsi64_si128(indexes4));
+        auto gathered = _mm256_i32gather_epi64(reinterpret_cast<const long long *>(bitmap), vindex, 8);
+        auto x = _mm256_and_si256(gathered, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i)));
+        acc = _mm256_add_epi64(acc, PopcntEpi64AVX2(x));
+    }
+    uint64_t cnt = HorizontalSumEpi64AVX2(acc);
+    for (; i < num_words; i++) {
+        cnt += __builtin_popcountll(bitmap[indexes[i]] & words[i]);
+    }
+    return cnt;
+}
+
+SIMD_TARGET_AVX512
+inline uint32_t GatherAndPopcntAVX512(const uint64_t *bitmap, const uint16_t *indexes, const uint64_t *words,
+                                      size_t num_words) {
+    auto acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= num_words; i += 8) {
+        auto vindex = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indexes + i)));
+        auto gathered = _mm512_i32gather_epi64(vindex, reinterpret_cast<const long long *>(bitmap), 8);
+        auto x = _mm512_and_si512(gathered, _mm512_loadu_si512(words + i));
+        // No vpopcntq in AVX-512F, count the two halves with the nibble lookup.
+        acc = _mm256_add_epi64(acc, PopcntEpi64AVX2(_mm512_castsi512_si256(x)));
+        acc = _mm256_add_epi64(acc, PopcntEpi64AVX2(_mm512_extracti64x4_epi64(x, 1)));
+    }
+    uint64_t cnt = HorizontalSumEpi64AVX2(acc);
+    for (; i < num_words; i++) {
+        cnt += __builtin_popcountll(bitmap[indexes[i]] & words[i]);
+    }
+    return cnt;
+}
+
+inline uint32_t GatherAndPopcnt(const uint64_t *bitmap, const uint16_t *indexes, const uint64_t *words,
+                                size_t num_words) {
+    switch (GetSIMDKind()) {
+        case SIMD_AVX512:
+            return GatherAndPopcntAVX512(bitmap, indexes, words, num_words);
+        case SIMD_AVX2:
+            return GatherAndPopcntAVX2(bitmap, indexes, words, num_words);
+        case SIMD_SSE4:
+            return GatherAndPopcntSSE4(bitmap, indexes, words, num_words);
+        default:
+            return GatherAndPopcntScalar(bitmap, indexes, words, num_words);
+    }
+}
@@ -39,4 +39,39 @@ public:
             submit();
         }
     }
-};
\ No newline at end of file
+};
+
+// LocalFlushBuffer is the sink version of LocalWriteBuffer: a full buffer is handed to flush_(buffer, size),
+// e.g., writing to a per-thread file shard or a user callback, instead of being appended to a global array.
+template<typename T, typename I, typename F>
+class LocalFlushBuffer {
+    T *buffer_;     // allocated outside, can be either stack or heap memory
+    I buffer_size_;
+    I buffer_cap_;
+
+    F flush_;
+
+    void submit() {
+        flush_(buffer_, buffer_size_);
+        buffer_size_ = 0;
+    }
+
+public:
+    LocalFlushBuffer() = delete;
+
+    LocalFlushBuffer(T *buffer, I buffer_cap, F flush) :
+            buffer_(buffer), buffer_size_(0), buffer_cap_(buffer_cap), flush_(flush) {}
+
+    void push(T data) {
+        buffer_[buffer_size_++] = data;
+        if (buffer_size_ >= buffer_cap_) {
+            submit();
+        }
+    }
+
+    void submit_if_possible() {
+        if (buffer_size_ != 0) {
+            submit();
+        }
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+// A cgroup limit at least this large is "no limit" (cgroup v1 reports the max page-aligned int64).
+#define CGROUP_UNLIMITED (1ull << 62u)
+
+/*
+ * The cgroup path of the process in /proc/self/cgroup ("<id>:<controllers>:<path>"), for the unified hierarchy
+ * (controller: nullptr, the "0::" line) or the v1 hierarchy with the controller; false if there is none.
+ */
+inline bool ReadCgroupPath(const char *controller, string &cgroup_path) {
+    FILE *file = fopen("/proc/self/cgroup", "r");
+    if (file == nullptr) {
+        return false;
+    }
+    bool found = false;
+    char line[4096];
+    while (!found && fgets(line, sizeof(line), file) != nullptr) {
+        string entry(line);
+        auto first = entry.find(':'), second = entry.find(':', first + 1);
+        if (first == string::npos || second == string::npos) {
+            continue;
+        }
+        auto controllers = entry.substr(first + 1, second - first - 1);
+        if (controller == nullptr) {
+            found = entry.compare(0, first, "0") == 0 && controllers.empty();
+        } else {
+            stringstream ss(controllers);
+            for (string item; !found && getline(ss, item, ',');) {
+                found = item == controller;
+            }
+        }
+        if (found) {
+            cgroup_path = entry.substr(second + 1);
+            while (!cgroup_path.empty() && (cgroup_path.back() == '\n' || cgroup_path.back() == '/')) {
+                cgroup_path.pop_back();
+            }
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+/*
+ * The tightest limit (bytes) in <mount><path>/<file_name> over the cgroup path and its ancestors (those visible in
+ * the mount), 0 if none ("max" or CGROUP_UNLIMITED).
+ */
+inline size_t ReadCgroupLimit(const string &mount, const string &cgroup_path, const char *file_name) {
+    size_t limit = 0;
+    char line[128];
+    for (auto path = cgroup_path;; path = path.substr(0, path.rfind('/'))) {
+        FILE *file = fopen((mount + path + "/" + file_name).c_str(), "r");
+        if (file != nullptr) {
+            if (fgets(line, sizeof(line), file) != nullptr && strncmp(line, "max", 3) != 0) {
+                size_t value = strtoull(line, nullptr, 10);
+                if (value > 0 && value < CGROUP_UNLIMITED) {
+                    limit = limit == 0 ? value : min(limit, value);
+                }
+            }
+            fclose(file);
+        }
+        if (path.empty()) {
+            break;
+        }
+    }
+    return limit;
+}
+
+// MemAvailable of /proc/meminfo (bytes), 0 if unreadable.
+inline size_t ReadMemAvailable() {
+    FILE *file = fopen("/proc/meminfo", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    size_t available = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (strncmp(line, "MemAvailable:", 13) == 0) {
+            available = strtoull(line + 13, nullptr, 10) * 1024;
+            break;
+        }
+    }
+    fclose(file);
+    return available;
+}
+
+/*
+ * The effective memory limit (bytes): the cgroup v2 memory.max (unified mount, or the hybrid one; the v1
+ * memory.limit_in_bytes otherwise), capped by MemAvailable, which is also the fallback without a cgroup limit;
+ * 0 if neither is known. source: where it comes from.
+ */
+inline size_t GetEffectiveMemLimit(string &source) {
+    size_t cgroup_limit = 0;
+    string cgroup_path;
+    if (ReadCgroupPath(nullptr, cgroup_path)) {
+        for (auto mount: {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+            auto limit = ReadCgroupLimit(mount, cgroup_path, "memory.max");
+            if (limit > 0) {
+                cgroup_limit = cgroup_limit == 0 ? limit : min(cgroup_limit, limit);
+                source = "cgroup v2 memory.max";
+            }
+        }
+    }
+    if (cgroup_limit == 0 && ReadCgroupPath("memory", cgroup_path)) {
+        cgroup_limit = ReadCgroupLimit("/sys/fs/cgroup/memory", cgroup_path, "memory.limit_in_bytes");
+        source = "cgroup v1 memory.limit_in_bytes";
+    }
+    auto available = ReadMemAvailable();
+    if (cgroup_limit > 0 && (available == 0 || cgroup_limit <= available)) {
+        return cgroup_limit;
+    }
+    source = available > 0 ? "MemAvailable" : "unknown";
+    return available;
+}
@@ -2,8 +2,10 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstring>
 
 #include <omp.h>
+#include <malloc.h>
 
 #include "local_buffer.h"
 
@@ -11,6 +13,8 @@ using namespace std;
 
 #define CACHE_LINE_ENTRY (16)
 #define LOCAL_BUDGET (8*1024*1024)
+#define RADIX_MAX_DIGIT_BITS (11)
+#define RADIX_WC_BYTES (64)
 
 template<typename T>
 void MemSetOMP(T *arr, int val, size_t size) {
@@ -19,7 +23,7 @@ void MemSetOMP(T *arr, int val, size_t size) {
 
     size_t task_num = size;
     size_t avg = (task_num + max_omp_threads - 1) / max_omp_threads;
-    auto it_beg = avg * tid;
+    auto it_beg = min(avg * tid, task_num);
     auto it_end = min(avg * (tid + 1), task_num);
     memset(arr + it_beg, val, sizeof(T) * (it_end - it_beg));
 #pragma omp barrier
@@ -32,7 +36,7 @@ void MemCpyOMP(T *dst, T *src, size_t size) {
 
     size_t task_num = size;
     size_t avg = (task_num + max_omp_threads - 1) / max_omp_threads;
-    auto it_beg = avg * tid;
+    auto it_beg = min(avg * tid, task_num);
     auto it_end = min(avg * (tid + 1), task_num);
     memcpy(dst + it_beg, src + it_beg, sizeof(T) * (it_end - it_beg));
 #pragma omp barrier
@@ -248,4 +252,78 @@ void BucketSortSmallBuckets(vector<H> &histogram, T *&input, T *&output,
     free(bucket_buffers);
     free(bucket_write_buffers);
 #pragma omp barrier
-}
\ No newline at end of file
+}
+
+/*
+ * RadixSortOMP: parallel LSD radix sort (stable) of the unsigned keys whose significant bits are the lowest num_bits
+ * histogram: the per-thread digit counts, exclusive-prefix-summed digit-major (then thread-major) per pass
+ * keys, buf: both of size elements, swapped after each pass, so that keys holds the sorted ones in the end
+ * The passes are ceil(num_bits / RADIX_MAX_DIGIT_BITS), with the bits evenly split into their digits; each thread
+ * scatters its static chunk through a write-combining buffer of one cache line per digit (software write-combining),
+ * so that the writes to the output go out by full lines.
+ */
+template<typename H, typename T>
+void RadixSortOMP(vector<H> &histogram, T *&keys, T *&buf, size_t size, int num_bits) {
+    constexpr size_t wc_entries = RADIX_WC_BYTES / sizeof(T);
+    size_t tid = omp_get_thread_num();
+    size_t max_omp_threads = omp_get_num_threads();
+    int num_passes = (num_bits + RADIX_MAX_DIGIT_BITS - 1) / RADIX_MAX_DIGIT_BITS;
+    if (num_passes == 0) {
+        return;
+    }
+    int digit_bits = (num_bits + num_passes - 1) / num_passes;
+    size_t num_buckets = size_t(1) << digit_bits;
+    T mask = static_cast<T>(num_buckets - 1);
+
+#pragma omp single
+    {
+        histogram = vector<H>(max_omp_threads * num_buckets);
+    }
+    size_t avg = (size + max_omp_threads - 1) / max_omp_threads;
+    auto it_beg = min(avg * tid, size);
+    auto it_end = min(avg * (tid + 1), size);
+    auto *wc_buf = (T *) memalign(RADIX_WC_BYTES, num_buckets * RADIX_WC_BYTES);
+    auto *wc_size = (uint8_t *) malloc(num_buckets);
+    for (int pass = 0; pass < num_passes; pass++) {
+        auto shift = pass * digit_bits;
+        // 1st: Local Histogram.
+        auto *local_histogram = &histogram[tid * num_buckets];
+        fill(local_histogram, local_histogram + num_buckets, 0);
+        for (auto i = it_beg; i < it_end; i++) {
+            local_histogram[(keys[i] >> shift) & mask]++;
+        }
+#pragma omp barrier
+        // 2nd: Exclusive Prefix Sum, digit-major for the stability.
+#pragma omp single
+        {
+            H prev = 0;
+            for (size_t d = 0; d < num_buckets; d++) {
+                for (size_t t = 0; t < max_omp_threads; t++) {
+                    auto tmp = histogram[t * num_buckets + d];
+                    histogram[t * num_buckets + d] = prev;
+                    prev += tmp;
+                }
+            }
+        }
+        // 3rd: Scatter via the write-combining buffers.
+        memset(wc_size, 0, num_buckets);
+        for (auto i = it_beg; i < it_end; i++) {
+            auto key = keys[i];
+            auto d = (key >> shift) & mask;
+            wc_buf[d * wc_entries + wc_size[d]++] = key;
+            if (wc_size[d] == wc_entries) {
+                memcpy(buf + local_histogram[d], wc_buf + d * wc_entries, RADIX_WC_BYTES);
+                local_histogram[d] += wc_entries;
+                wc_size[d] = 0;
+            }
+        }
+        for (size_t d = 0; d < num_buckets; d++) {
+            memcpy(buf + local_histogram[d], wc_buf + d * wc_entries, sizeof(T) * wc_size[d]);
+        }
+#pragma omp barrier
+#pragma omp single
+        swap(keys, buf);
+    }
+    free(wc_size);
+    free(wc_buf);
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <malloc.h>
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <omp.h>
+
+#include "graph.h"
+#include "log.h"
+#include "timer.h"
+#include "libpopcnt.h"
+#include "primitives.h"
+#include "simd_dispatch.h"
+
+/*
+ * Roaring Index of N+(u) for all u: the neighbors are grouped by the high 16 bits of their IDs (the key),
+ * each group is a container of the low 16 bits, encoded as (the smallest of):
+ * array: the sorted lows (2 bytes per value, at most ROARING_ARRAY_MAX_CARD values),
+ * bitmap: 2^16 bits (ROARING_BITMAP_WORDS words),
+ * run: (start, length - 1) pairs of the consecutive lows (4 bytes per run).
+ * The intersection of N+(u) and N+(v) merges the keys, and intersects the containers pairwise (AND and popcount).
+ */
+#define ROARING_ARRAY_MAX_CARD (4096)
+#define ROARING_BITMAP_WORDS (1024)
+#define ROARING_GALLOP_RATIO (32)
+
+enum roaring_kind_t {
+    ROARING_ARRAY = 0, ROARING_BITMAP = 1, ROARING_RUN = 2, ROARING_KIND_NUM = 3
+};
+
+inline const char *RoaringKindName(roaring_kind_t kind) {
+    static const char *names[] = {"array", "bitmap", "run"};
+    return names[kind];
+}
+
+struct roaring_container_t {
+    uint16_t key;
+    uint8_t kind;
+    uint32_t size;      // array: number of values, bitmap: cardinality, run: number of runs
+    size_t off;         // array, run: offset in lows, bitmap: offset in bitmap_words
+};
+
+struct roaring_index_t {
+    row_ptr_t *cont_ptrs;   // the containers of u: [cont_ptrs[u], cont_ptrs[u + 1])
+    roaring_container_t *conts;
+    uint16_t *lows;
+    uint64_t *bitmap_words;
+    size_t num_conts[ROARING_KIND_NUM];
+};
+
+inline void FreeRoaringIndex(roaring_index_t &idx) {
+    free(idx.cont_ptrs);
+    free(idx.conts);
+    free(idx.lows);
+    free(idx.bitmap_words);
+}
+
+inline roaring_kind_t SelectRoaringKind(uint32_t card, uint32_t num_runs) {
+    auto array_bytes = card <= ROARING_ARRAY_MAX_CARD ? 2 * card : UINT32_MAX;
+    auto bitmap_bytes = ROARING_BITMAP_WORDS * 8u;
+    if (4 * num_runs < min(array_bytes, bitmap_bytes)) {
+        return ROARING_RUN;
+    }
+    return array_bytes <= bitmap_bytes ? ROARING_ARRAY : ROARING_BITMAP;
+}
+
+// Visits the groups of N+(u) sharing a key: f(key, off_beg, off_end, num_runs).
+template<typename F>
+inline void ForEachRoaringGroup(graph_t &g, uint32_t u, F f) {
+    auto off = g.row_ptrs[u];
+    while (off < g.row_ptrs[u + 1]) {
+        auto key = static_cast<uint32_t>(g.adj[off]) >> 16;
+        auto beg = off;
+        uint32_t num_runs = 1;
+        for (off++; off < g.row_ptrs[u + 1] && static_cast<uint32_t>(g.adj[off]) >> 16 == key; off++) {
+            num_runs += g.adj[off] != g.adj[off - 1] + 1;
+        }
+        f(key, beg, off, num_runs);
+    }
+}
+
+/*
+ * BuildRoaringIndex: two passes over the (sorted) out-neighbors, the 1st one counts the containers, the lows and the
+ * bitmaps of u, the 2nd one fills them at the prefix-summed offsets.
+ */
+inline roaring_index_t BuildRoaringIndex(graph_t &g, int max_omp_threads) {
+    Timer timer;
+    roaring_index_t idx{};
+    idx.cont_ptrs = (row_ptr_t *) malloc(sizeof(row_ptr_t) * (g.n + 1));
+    auto *low_ptrs = (size_t *) malloc(sizeof(size_t) * (g.n + 1));
+    auto *bitmap_ptrs = (size_t *) malloc(sizeof(size_t) * (g.n + 1));
+    // Per-vertex counts of the containers, the lows and the bitmaps of the 1st pass.
+    auto *local_cnts = (uint32_t *) malloc(sizeof(uint32_t) * 3 * max<long>(g.n, 1));
+    idx.cont_ptrs[0] = low_ptrs[0] = bitmap_ptrs[0] = 0;
+    vector<size_t> histogram;
+    size_t num_conts[ROARING_KIND_NUM] = {0};
+
+#pragma omp parallel num_threads(max_omp_threads)
+    {
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < g.n; u++) {
+            uint32_t cnt[3] = {0, 0, 0};
+            ForEachRoaringGroup(g, u, [&](uint32_t, row_ptr_t beg, row_ptr_t end, uint32_t num_runs) {
+                cnt[0]++;
+                switch (SelectRoaringKind(end - beg, num_runs)) {
+                    case ROARING_ARRAY:
+                        cnt[1] += end - beg;
+                        break;
+                    case ROARING_RUN:
+                        cnt[1] += 2 * num_runs;
+                        break;
+                    default:
+                        cnt[2]++;
+                }
+            });
+            memcpy(local_cnts + 3 * static_cast<size_t>(u), cnt, sizeof(cnt));
+        }
+        InclusivePrefixSumOMP(histogram, idx.cont_ptrs + 1, g.n, [local_cnts](size_t u) { return local_cnts[3 * u]; });
+        InclusivePrefixSumOMP(histogram, low_ptrs + 1, g.n, [local_cnts](size_t u) { return local_cnts[3 * u + 1]; });
+        InclusivePrefixSumOMP(histogram, bitmap_ptrs + 1, g.n,
+                              [local_cnts](size_t u) { return local_cnts[3 * u + 2]; });
+#pragma omp single
+        {
+            idx.conts = (roaring_container_t *) malloc(sizeof(roaring_container_t) *
+                                                       max<size_t>(idx.cont_ptrs[g.n], 1));
+            idx.lows = (uint16_t *) malloc(sizeof(uint16_t) * max<size_t>(low_ptrs[g.n], 1));
+            idx.bitmap_words = (uint64_t *) memalign(64, sizeof(uint64_t) * ROARING_BITMAP_WORDS *
+                                                         max<size_t>(bitmap_ptrs[g.n], 1));
+        }
+        size_t local_num_conts[ROARING_KIND_NUM] = {0};
+#pragma omp for schedule(dynamic, 1024)
+        for (auto u = 0u; u < g.n; u++) {
+            auto cont_idx = idx.cont_ptrs[u];
+            auto low_off = low_ptrs[u];
+            auto bitmap_off = bitmap_ptrs[u] * ROARING_BITMAP_WORDS;
+            ForEachRoaringGroup(g, u, [&](uint32_t key, row_ptr_t beg, row_ptr_t end, uint32_t num_runs) {
+                auto kind = SelectRoaringKind(end - beg, num_runs);
+                local_num_conts[kind]++;
+                auto &cont = idx.conts[cont_idx++];
+                cont.key = key;
+                cont.kind = kind;
+                if (kind == ROARING_ARRAY) {
+                    cont.size = end - beg;
+                    cont.off = low_off;
+                    for (auto off = beg; off < end; off++) {
+                        idx.lows[low_off++] = g.adj[off] & 0xffff;
+                    }
+                } else if (kind == ROARING_RUN) {
+                    cont.size = num_runs;
+                    cont.off = low_off;
+                    for (auto off = beg; off < end;) {
+                        auto run_beg = off;
+                        for (off++; off < end && g.adj[off] == g.adj[off - 1] + 1; off++);
+                        idx.lows[low_off++] = g.adj[run_beg] & 0xffff;
+                        idx.lows[low_off++] = off - run_beg - 1;
+                    }
+                } else {
+                    cont.size = end - beg;
+                    cont.off = bitmap_off;
+                    auto *bitmap = idx.bitmap_words + bitmap_off;
+                    memset(bitmap, 0, sizeof(uint64_t) * ROARING_BITMAP_WORDS);
+                    for (auto off = beg; off < end; off++) {
+                        auto low = g.adj[off] & 0xffff;
+                        bitmap[low >> 6] |= 1ull << (low & 63);
+                    }
+                    bitmap_off += ROARING_BITMAP_WORDS;
+                }
+            });
+        }
+        for (auto kind = 0; kind < ROARING_KIND_NUM; kind++) {
+            __sync_fetch_and_add(&num_conts[kind], local_num_conts[kind]);
+        }
+    }
+    memcpy(idx.num_conts, num_conts, sizeof(num_conts));
+    log_info("Roaring Index Time: %.3lfs, containers (array/bitmap/run): %zu/%zu/%zu, size: %zu KB",
+             timer.elapsed(), num_conts[ROARING_ARRAY], num_conts[ROARING_BITMAP], num_conts[ROARING_RUN],
+             (sizeof(roaring_container_t) * idx.cont_ptrs[g.n] + sizeof(uint16_t) * low_ptrs[g.n] +
+              sizeof(uint64_t) * ROARING_BITMAP_WORDS * bitmap_ptrs[g.n]) / 1024);
+    free(low_ptrs);
+    free(bitmap_ptrs);
+    free(local_cnts);
+    return idx;
+}
+
+SIMD_TARGET_SSE4
+inline uint32_t AndPopcntWordsHW(const uint64_t *a, const uint64_t *b, size_t num_words) {
+    uint64_t cnt = 0;
+    for (size_t i = 0; i < num_words; i++) {
+        cnt += __builtin_popcountll(a[i] & b[i]);
+    }
+    return cnt;
+}
+
+inline uint32_t AndPopcntWords(const uint64_t *a, const uint64_t *b, size_t num_words) {
+    if (GetSIMDKind() != SIMD_SCALAR) {
+        return AndPopcntWordsHW(a, b, num_words);
+    }
+    uint64_t cnt = 0;
+    for (size_t i = 0; i < num_words; i++) {
+        cnt += popcount64(a[i] & b[i]);
+    }
+    return cnt;
+}
+
+// The set bits of the bitmap in [beg, end].
+inline uint32_t PopcntBitRange(const uint64_t *bitmap, uint32_t beg, uint32_t end) {
+    auto beg_word = beg >> 6, end_word = end >> 6;
+    auto beg_mask = ~0ull << (beg & 63), end_mask = ~0ull >> (63 - (end & 63));
+    if (beg_word == end_word) {
+        return popcount64(bitmap[beg_word] & beg_mask & end_mask);
+    }
+    uint32_t cnt = popcount64(bitmap[beg_word] & beg_mask) + popcount64(bitmap[end_word] & end_mask);
+    for (auto w = beg_word + 1; w < end_word; w++) {
+        cnt += popcount64(bitmap[w]);
+    }
+    return cnt;
+}
+
+inline uint32_t ArrayArrayCnt(const uint16_t *a, uint32_t na, const uint16_t *b, uint32_t nb) {
+    if (na > nb) {
+        swap(a, b);
+        swap(na, nb);
+    }
+    uint32_t cnt = 0;
+    if (na * ROARING_GALLOP_RATIO < nb) {
+        auto *it = b;
+        for (uint32_t i = 0; i < na && it < b + nb; i++) {
+            it = lower_bound(it, b + nb, a[i]);
+            cnt += it < b + nb && *it == a[i];
+        }
+        return cnt;
+    }
+    uint32_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        auto x = a[i], y = b[j];
+        cnt += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return cnt;
+}
+
+inline uint32_t ArrayBitmapCnt(const uint16_t *a, uint32_t na, const uint64_t *bitmap) {
+    uint32_t cnt = 0;
+    for (uint32_t i = 0; i < na; i++) {
+        cnt += (bitmap[a[i] >> 6] >> (a[i] & 63)) & 1;
+    }
+    return cnt;
+}
+
+// runs: (start, length - 1) pairs.
+inline uint32_t ArrayRunCnt(const uint16_t *a, uint32_t na, const uint16_t *runs, uint32_t num_runs) {
+    uint32_t cnt = 0;
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < na && r < num_runs; i++) {
+        for (; r < num_runs && runs[2 * r] + runs[2 * r + 1] < a[i]; r++);
+        cnt += r < num_runs && runs[2 * r] <= a[i];
+    }
+    return cnt;
+}
+
+inline uint32_t BitmapRunCnt(const uint64_t *bitmap, const uint16_t *runs, uint32_t num_runs) {
+    uint32_t cnt = 0;
+    for (uint32_t r = 0; r < num_runs; r++) {
+        cnt += PopcntBitRange(bitmap, runs[2 * r], runs[2 * r] + runs[2 * r + 1]);
+    }
+    return cnt;
+}
+
+inline uint32_t RunRunCnt(const uint16_t *a, uint32_t na, const uint16_t *b, uint32_t nb) {
+    uint32_t cnt = 0;
+    uint32_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        uint32_t a_end = a[2 * i] + a[2 * i + 1], b_end = b[2 * j] + b[2 * j + 1];
+        uint32_t beg = max(a[2 * i], b[2 * j]), end = min(a_end, b_end);
+        cnt += beg <= end ? end - beg + 1 : 0;
+        i += a_end <= b_end;
+        j += b_end <= a_end;
+    }
+    return cnt;
+}
+
+inline uint32_t RoaringContainerCnt(const roaring_index_t &idx, const roaring_container_t *ca,
+                                    const roaring_container_t *cb) {
+    if (ca->kind > cb->kind) {
+        swap(ca, cb);
+    }
+    switch (ca->kind * ROARING_KIND_NUM + cb->kind) {
+        case ROARING_ARRAY * ROARING_KIND_NUM + ROARING_ARRAY:
+            return ArrayArrayCnt(idx.lows + ca->off, ca->size, idx.lows + cb->off, cb->size);
+        case ROARING_ARRAY * ROARING_KIND_NUM + ROARING_BITMAP:
+            return ArrayBitmapCnt(idx.lows + ca->off, ca->size, idx.bitmap_words + cb->off);
+        case ROARING_ARRAY * ROARING_KIND_NUM + ROARING_RUN:
+            return ArrayRunCnt(idx.lows + ca->off, ca->size, idx.lows + cb->off, cb->size);
+        case ROARING_BITMAP * ROARING_KIND_NUM + ROARING_BITMAP:
+            return AndPopcntWords(idx.bitmap_words + ca->off, idx.bitmap_words + cb->off, ROARING_BITMAP_WORDS);
+        case ROARING_BITMAP * ROARING_KIND_NUM + ROARING_RUN:
+            return BitmapRunCnt(idx.bitmap_words + ca->off, idx.lows + cb->off, cb->size);
+        default:
+            return RunRunCnt(idx.lows + ca->off, ca->size, idx.lows + cb->off, cb->size);
+    }
+}
+
+// |N+(u) & N+(v)|: merges the keys of u and v.
+inline uint32_t RoaringInterCnt(const roaring_index_t &idx, uint32_t u, uint32_t v) {
+    auto *ca = idx.conts + idx.cont_ptrs[u], *ca_end = idx.conts + idx.cont_ptrs[u + 1];
+    auto *cb = idx.conts + idx.cont_ptrs[v], *cb_end = idx.conts + idx.cont_ptrs[v + 1];
+    uint32_t cnt = 0;
+    while (ca < ca_end && cb < cb_end) {
+        if (ca->key < cb->key) {
+            ca++;
+        } else if (ca->key > cb->key) {
+            cb++;
+        } else {
+            cnt += RoaringContainerCnt(idx, ca++, cb++);
+        }
+    }
+    return cnt;
+}
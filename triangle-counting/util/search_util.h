@@ -4,6 +4,24 @@
 
 #include <cstdint>
 
+#include "simd_dispatch.h"
+
+/*
+ * The SIMD searches here and the SIMD set intersections (set_inter_cnt_utils.h, set_inter_emit_utils.h) only load
+ * the elements in [offset_beg, offset_end): a partial vector is loaded by LoadPartial*, masked to its first num
+ * lanes (zeros above, never read from memory), so the arrays given to them (e.g., the adj) need no padding.
+ */
+SIMD_TARGET_AVX2
+inline __m256i LoadPartialAVX2(const int *array, int num) {
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_maskload_epi32(array, _mm256_cmpgt_epi32(_mm256_set1_epi32(num), lanes));
+}
+
+SIMD_TARGET_AVX512
+inline __m512i LoadPartialAVX512(const int *array, int num) {
+    return _mm512_maskz_loadu_epi32(static_cast<__mmask16>((1u << num) - 1), array);
+}
+
 template<typename T, typename OFF>
 OFF LinearSearch(T *array, OFF offset_beg, OFF offset_end, T val) {
     // linear search fallback
@@ -63,9 +81,8 @@ OFF GallopingSearch(T *array, OFF offset_beg, OFF offset_end, T val) {
 
 #include <x86intrin.h>
 
-#ifdef __AVX2__
-
 template<typename OFF>
+SIMD_TARGET_AVX2
 OFF LinearSearchAVX2(const int32_t *array, OFF offset_beg, OFF offset_end, int32_t val) {
     // linear search fallback
     __m256i pivot_element = _mm256_set1_epi32(val);
@@ -78,7 +95,7 @@ OFF LinearSearchAVX2(const int32_t *array, OFF offset_beg, OFF offset_end, int32
 
     // offset_end - offset_beg <= 8
     auto left_size = offset_end - offset_beg;
-    __m256i elements = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(array + offset_beg));
+    __m256i elements = LoadPartialAVX2(array + offset_beg, left_size);
     __m256i cmp_res = _mm256_cmpgt_epi32(pivot_element, elements);
     int mask = _mm256_movemask_epi8(cmp_res);
     int cmp_mask = 0xffffffff >> ((8 - left_size) << 2);
@@ -88,6 +105,7 @@ OFF LinearSearchAVX2(const int32_t *array, OFF offset_beg, OFF offset_end, int32
 }
 
 template<typename OFF>
+SIMD_TARGET_AVX2
 OFF BinarySearchForGallopingSearchAVX2(const int32_t *array, OFF offset_beg, OFF offset_end, int32_t val) {
     while (offset_end - offset_beg >= 16) {
         auto mid = static_cast<uint32_t>((static_cast<unsigned long>(offset_beg) + offset_end) / 2);
@@ -113,7 +131,7 @@ OFF BinarySearchForGallopingSearchAVX2(const int32_t *array, OFF offset_beg, OFF
 
     // offset_end - offset_beg <= 8
     auto left_size = offset_end - offset_beg;
-    __m256i elements = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(array + offset_beg));
+    __m256i elements = LoadPartialAVX2(array + offset_beg, left_size);
     __m256i cmp_res = _mm256_cmpgt_epi32(pivot_element, elements);
     int mask = _mm256_movemask_epi8(cmp_res);
     int cmp_mask = 0xffffffff >> ((8 - left_size) << 2);
@@ -124,6 +142,7 @@ OFF BinarySearchForGallopingSearchAVX2(const int32_t *array, OFF offset_beg, OFF
 
 // Assuming size > 0
 template<typename OFF>
+SIMD_TARGET_AVX2
 OFF GallopingSearchAVX2(int *array, OFF offset_beg, OFF offset_end, int val) {
 // Not necessary because of the linear search.
 //    if (array[offset_end - 1] < val) {
@@ -139,7 +158,7 @@ OFF GallopingSearchAVX2(int *array, OFF offset_beg, OFF offset_end, int val) {
         if (mask != 0xffffffff) { return offset_beg + (_popcnt32(mask) >> 2); }
     } else {
         auto left_size = offset_end - offset_beg;
-        __m256i elements = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(array + offset_beg));
+        __m256i elements = LoadPartialAVX2(array + offset_beg, left_size);
         __m256i cmp_res = _mm256_cmpgt_epi32(pivot_element, elements);
         int mask = _mm256_movemask_epi8(cmp_res);
         int cmp_mask = 0xffffffff >> ((8 - left_size) << 2);
@@ -163,11 +182,8 @@ OFF GallopingSearchAVX2(int *array, OFF offset_beg, OFF offset_end, int val) {
     }
 }
 
-#endif
-
-#ifdef __AVX512F__
-
 template<typename OFF>
+SIMD_TARGET_AVX512
 OFF LinearSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
     constexpr int parallelism = 16;
     __m512i pivot_element = _mm512_set1_epi32(val);
@@ -178,7 +194,7 @@ OFF LinearSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
     }
     if (offset_beg < offset_end) {
         auto left_size = offset_end - offset_beg;
-        __m512i elements = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(array + offset_beg));
+        __m512i elements = LoadPartialAVX512(array + offset_beg, left_size);
         __mmask16 mask = _mm512_cmplt_epi32_mask(elements, pivot_element);
         __mmask16 cmp_mask = ((__mmask16) 0xffff) >> (16 - left_size);
         mask &= cmp_mask;
@@ -188,6 +204,7 @@ OFF LinearSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
 }
 
 template<typename OFF>
+SIMD_TARGET_AVX512
 OFF BinarySearchForGallopingSearchAVX512(const int *array, OFF offset_beg, OFF offset_end, int val) {
     while (offset_end - offset_beg >= 32) {
         auto mid = static_cast<uint32_t>((static_cast<unsigned long>(offset_beg) + offset_end) / 2);
@@ -212,7 +229,7 @@ OFF BinarySearchForGallopingSearchAVX512(const int *array, OFF offset_beg, OFF o
     }
     if (offset_beg < offset_end) {
         auto left_size = offset_end - offset_beg;
-        __m512i elements = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(array + offset_beg));
+        __m512i elements = LoadPartialAVX512(array + offset_beg, left_size);
         __mmask16 mask = _mm512_cmplt_epi32_mask(elements, pivot_element);
         __mmask16 cmp_mask = ((__mmask16) 0xffff) >> (16 - left_size);
         mask &= cmp_mask;
@@ -222,6 +239,7 @@ OFF BinarySearchForGallopingSearchAVX512(const int *array, OFF offset_beg, OFF o
 }
 
 template<typename OFF>
+SIMD_TARGET_AVX512
 OFF GallopingSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
     if (array[offset_end - 1] < val) {
         return offset_end;
@@ -235,7 +253,7 @@ OFF GallopingSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
         __mmask16 mask = _mm512_cmplt_epi32_mask(elements, pivot_element);
         if (mask != 0xffff) { return offset_beg + _mm_popcnt_u32(mask); }
     } else {
-        __m512i elements = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(array + offset_beg));
+        __m512i elements = LoadPartialAVX512(array + offset_beg, left_size);
         __mmask16 mask = _mm512_cmplt_epi32_mask(elements, pivot_element);
         __mmask16 cmp_mask = ((__mmask16) 0xffff) >> (16 - left_size);
         mask &= cmp_mask;
@@ -263,5 +281,3 @@ OFF GallopingSearchAVX512(int *array, OFF offset_beg, OFF offset_end, int val) {
         }
     }
 }
-
-#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <random>
+#include <algorithm>
+#include <limits>
+
+#include "graph.h"
+#include "timer.h"
+#include "log.h"
+#include "boolarray.h"
+#include "set_inter_cnt_utils.h"
+
+/*
+ * Adaptive Set Intersection (Count), per (u, v) pair the cheapest of:
+ * 1st: vectorized merge (SetInterCntVecMerge), cost ~ du + dv.
+ * 2nd: galloping (SetInterLookup), cost ~ min(du, dv) * log(max(du, dv) / min(du, dv)).
+ * 3rd: bitmap probe of v's list against u's bitmap (only if the bitmap of u is built), cost ~ dv.
+ * The per-unit costs are calibrated at startup with a microbenchmark on the running machine.
+ */
+#define SET_INTER_CALIBRATE_SMALL (64)
+#define SET_INTER_CALIBRATE_ELEMENTS (1024 * 1024)
+#define SET_INTER_CALIBRATE_MAX_RATIO (256)
+
+enum set_inter_path_t {
+    SET_INTER_PATH_MERGE = 0, SET_INTER_PATH_LOOKUP = 1, SET_INTER_PATH_PROBE = 2, SET_INTER_PATH_NUM = 3
+};
+
+inline const char *SetInterPathName(set_inter_path_t path) {
+    static const char *names[] = {"merge", "lookup", "probe"};
+    return names[path];
+}
+
+// Nanoseconds per unit of the estimated work, see above.
+struct set_inter_cost_model_t {
+    double merge_ns;
+    double lookup_ns;
+    double probe_ns;
+};
+
+inline uint32_t FloorLog2(uint64_t x) {
+    return 63 - __builtin_clzll(x | 1);
+}
+
+template<typename OFF>
+inline set_inter_path_t SelectSetInterPath(const set_inter_cost_model_t &model, OFF du, OFF dv, bool is_probe_ok) {
+    auto d_min = min(du, dv);
+    auto d_max = max(du, dv);
+    auto merge_cost = model.merge_ns * (du + dv);
+    auto lookup_cost = model.lookup_ns * d_min * (FloorLog2(d_max / max<OFF>(d_min, 1)) + 1);
+    auto probe_cost = is_probe_ok ? model.probe_ns * dv : numeric_limits<double>::max();
+    if (probe_cost <= merge_cost && probe_cost <= lookup_cost) {
+        return SET_INTER_PATH_PROBE;
+    }
+    return lookup_cost < merge_cost ? SET_INTER_PATH_LOOKUP : SET_INTER_PATH_MERGE;
+}
+
+// base: the vertex ID of the bitmap's first bit
+template<typename OFF, typename W>
+inline int BitmapProbeCnt(graph_t *g, const BoolArray<W> &bitmap, int32_t base, OFF off_nei_v, OFF vEnd) {
+    int cn_count = 0;
+    for (auto off = off_nei_v; off < vEnd; off++) {
+        cn_count += bitmap.get(g->adj[off] - base);
+    }
+    return cn_count;
+}
+
+/*
+ * CalibrateSetInterCostModel: a small list (SET_INTER_CALIBRATE_SMALL) against large ones (small * ratio,
+ * ratio = 1, 2, 4, ..., SET_INTER_CALIBRATE_MAX_RATIO), half of the small one in common, values in [0, bitmap_range).
+ * The probe goes over the large lists, spread over the bitmap, to account for its cache misses.
+ */
+inline set_inter_cost_model_t CalibrateSetInterCostModel(uint32_t bitmap_range) {
+    Timer timer;
+    constexpr row_ptr_t small_size = SET_INTER_CALIBRATE_SMALL;
+    constexpr row_ptr_t max_large_size = small_size * SET_INTER_CALIBRATE_MAX_RATIO;
+    // Padding for the vectorized loads at the end of the lists.
+    vector<int32_t> adj(small_size + max_large_size + 64);
+    graph_t g{.n=0, .m=0, .adj=&adj.front(), .row_ptrs=nullptr};
+    BoolArray<uint64_t> bitmap(bitmap_range);
+    mt19937 gen(0);
+
+    double merge_time = 0, lookup_time = 0, probe_time = 0;
+    double merge_work = 0, lookup_work = 0, probe_work = 0;
+    volatile size_t sink = 0;
+    for (uint32_t ratio = 1; ratio <= SET_INTER_CALIBRATE_MAX_RATIO; ratio *= 2) {
+        row_ptr_t large_size = small_size * ratio;
+        auto max_gap = max<int32_t>(2, bitmap_range / large_size);
+        // Large list: random gaps, Small list: every other one from the large list, interleaved with values not in it.
+        int32_t val = 0;
+        for (row_ptr_t i = 0; i < large_size; i++) {
+            val += 1 + gen() % max_gap;
+            adj[small_size + i] = min<int32_t>(val, bitmap_range - 1);
+        }
+        for (row_ptr_t i = 0; i < small_size; i++) {
+            auto large_idx = (i * large_size) / small_size;
+            adj[i] = (i % 2 == 0 || ratio == 1) ? adj[small_size + large_idx] : adj[small_size + large_idx] + 1;
+        }
+        for (row_ptr_t i = 0; i < small_size; i++) {
+            bitmap.set(adj[i]);
+        }
+
+        auto reps = max<size_t>(1, SET_INTER_CALIBRATE_ELEMENTS / (small_size + large_size));
+        Timer local_timer;
+        for (size_t r = 0; r < reps; r++) {
+            sink += SetInterCntVecMerge(&g, (row_ptr_t) 0, small_size, small_size, small_size + large_size);
+        }
+        merge_time += local_timer.elapsed_and_reset();
+        for (size_t r = 0; r < reps; r++) {
+            sink += SetInterLookup(&g, (row_ptr_t) 0, small_size, small_size, small_size + large_size);
+        }
+        lookup_time += local_timer.elapsed_and_reset();
+        for (size_t r = 0; r < reps; r++) {
+            sink += BitmapProbeCnt(&g, bitmap, 0, small_size, small_size + large_size);
+        }
+        probe_time += local_timer.elapsed_and_reset();
+        bitmap.reset();
+
+        merge_work += reps * (small_size + large_size);
+        lookup_work += reps * small_size * (FloorLog2(ratio) + 1);
+        probe_work += reps * large_size;
+    }
+    set_inter_cost_model_t model{.merge_ns = merge_time / merge_work * 1e9,
+            .lookup_ns = lookup_time / lookup_work * 1e9, .probe_ns = probe_time / probe_work * 1e9};
+    log_info("Calibrated Cost (ns/unit), merge: %.3lf, lookup: %.3lf, probe: %.3lf, time: %.6lfs",
+             model.merge_ns, model.lookup_ns, model.probe_ns, timer.elapsed());
+    return model;
+}
@@ -4,34 +4,25 @@
 
 #include "graph.h"
 #include "search_util.h"
+#include "simd_dispatch.h"
 
 using eid_t = uint32_t;
 
 //#define ENABLE_AVX2
 
 template <typename OFF>
-inline int SetInterLookup(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
+inline int SetInterLookupScalar(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
     if (uEnd - off_nei_u > vEnd - off_nei_v) {
         swap(uEnd, vEnd);
         swap(off_nei_u, off_nei_v);
     }
     int cnt = 0;
     while (true) {
-#ifdef __AVX512F__
-        off_nei_u = LinearSearchAVX512(g->adj, off_nei_u, uEnd, g->adj[off_nei_v]);
-#else
         off_nei_u = LinearSearch(g->adj, off_nei_u, uEnd, g->adj[off_nei_v]);
-#endif
         if (off_nei_u >= uEnd) {
             break;
         }
-#ifdef __AVX512F__
-        off_nei_v = GallopingSearchAVX512(g->adj, off_nei_v, vEnd, g->adj[off_nei_u]);
-#elif defined(__AVX2__) && defined(ENABLE_AVX2)
-        off_nei_v = GallopingSearchAVX2(g->adj, off_nei_v, vEnd, g->adj[off_nei_u]);
-#else
         off_nei_v = GallopingSearch(g->adj, off_nei_v, vEnd, g->adj[off_nei_u]);
-#endif
         if (off_nei_v >= vEnd) {
             break;
         }
@@ -47,6 +38,78 @@ inline int SetInterLookup(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OF
     return cnt;
 }
 
+template <typename OFF>
+SIMD_TARGET_AVX2
+inline int SetInterLookupAVX2(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
+    if (uEnd - off_nei_u > vEnd - off_nei_v) {
+        swap(uEnd, vEnd);
+        swap(off_nei_u, off_nei_v);
+    }
+    int cnt = 0;
+    while (true) {
+        off_nei_u = LinearSearch(g->adj, off_nei_u, uEnd, g->adj[off_nei_v]);
+        if (off_nei_u >= uEnd) {
+            break;
+        }
+        off_nei_v = GallopingSearchAVX2(g->adj, off_nei_v, vEnd, g->adj[off_nei_u]);
+        if (off_nei_v >= vEnd) {
+            break;
+        }
+        if (g->adj[off_nei_u] == g->adj[off_nei_v]) {
+            cnt++;
+            ++off_nei_u;
+            ++off_nei_v;
+            if (off_nei_u >= uEnd || off_nei_v >= vEnd) {
+                break;
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_AVX512
+inline int SetInterLookupAVX512(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
+    if (uEnd - off_nei_u > vEnd - off_nei_v) {
+        swap(uEnd, vEnd);
+        swap(off_nei_u, off_nei_v);
+    }
+    int cnt = 0;
+    while (true) {
+        off_nei_u = LinearSearchAVX512(g->adj, off_nei_u, uEnd, g->adj[off_nei_v]);
+        if (off_nei_u >= uEnd) {
+            break;
+        }
+        off_nei_v = GallopingSearchAVX512(g->adj, off_nei_v, vEnd, g->adj[off_nei_u]);
+        if (off_nei_v >= vEnd) {
+            break;
+        }
+        if (g->adj[off_nei_u] == g->adj[off_nei_v]) {
+            cnt++;
+            ++off_nei_u;
+            ++off_nei_v;
+            if (off_nei_u >= uEnd || off_nei_v >= vEnd) {
+                break;
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+inline int SetInterLookup(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
+    switch (GetSIMDKind()) {
+        case SIMD_AVX512:
+            return SetInterLookupAVX512(g, off_nei_u, uEnd, off_nei_v, vEnd);
+#ifdef ENABLE_AVX2
+        case SIMD_AVX2:
+            return SetInterLookupAVX2(g, off_nei_u, uEnd, off_nei_v, vEnd);
+#endif
+        default:
+            return SetInterLookupScalar(g, off_nei_u, uEnd, off_nei_v, vEnd);
+    }
+}
+
 template <typename OFF>
 inline int SetIntersectionScalarCntDetail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
     int cnt = 0;
@@ -72,13 +135,11 @@ inline int SetIntersectionScalarCntDetail(graph_t *g, OFF off_nei_u, OFF uEnd, O
     return cnt;
 }
 
-
-#if defined(__SSE4_1__)
-
 /*
  * Set Intersection Count Begin (SSE4) ========================================
  */
 template <typename OFF>
+SIMD_TARGET_SSE4
 inline int SetInterCntSSE4DetailOneFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
                                         OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
@@ -109,15 +170,16 @@ inline int SetInterCntSSE4DetailOneFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
 }
 
 template <typename OFF>
+SIMD_TARGET_SSE4
 inline int SetInterCntSSE4DetailTwoTwo(graph_t *g, OFF &off_nei_u, OFF uEnd,
                                        OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
     constexpr int per_u_order = 0b01010000;
     constexpr int per_v_order = 0b01000100;
     if (off_nei_u + 1 < uEnd && off_nei_v + 1 < vEnd) {
-        __m128i u_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_u));
+        __m128i u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
         __m128i u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
-        __m128i v_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_v));
+        __m128i v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
         __m128i v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
 
         while (true) {
@@ -133,23 +195,23 @@ inline int SetInterCntSSE4DetailTwoTwo(graph_t *g, OFF &off_nei_u, OFF uEnd,
                 if (off_nei_u + 1 >= uEnd || off_nei_v + 1 >= vEnd) {
                     break;
                 }
-                u_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_u));
+                u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
                 u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
-                v_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_v));
+                v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
                 v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
             } else if (g->adj[off_nei_u + 1] > g->adj[off_nei_v + 1]) {
                 off_nei_v += 2;
                 if (off_nei_v + 1 >= vEnd) {
                     break;
                 }
-                v_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_v));
+                v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
                 v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
             } else {
                 off_nei_u += 2;
                 if (off_nei_u + 1 >= uEnd) {
                     break;
                 }
-                u_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_u));
+                u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
                 u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
             }
         }
@@ -158,6 +220,7 @@ inline int SetInterCntSSE4DetailTwoTwo(graph_t *g, OFF &off_nei_u, OFF uEnd,
 }
 
 template <typename OFF>
+SIMD_TARGET_SSE4
 inline int SetInterCntSSE4Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
     int cnt = 0;
     auto size_ratio = (vEnd - off_nei_v) / (uEnd - off_nei_u);
@@ -173,12 +236,11 @@ inline int SetInterCntSSE4Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_ne
  * Set Intersection Count End (SSE4) ========================================
  */
 
-#if defined(__AVX2__)
-
 /*
  * Set Intersection Count Begin (AVX2) ========================================
  */
 template <typename OFF>
+SIMD_TARGET_AVX2
 inline int SetInterCntAVX2DetailOneEight(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
     if (off_nei_u < uEnd && off_nei_v + 7 < vEnd) {
@@ -208,15 +270,16 @@ inline int SetInterCntAVX2DetailOneEight(graph_t *g, OFF &off_nei_u, OFF uEnd, O
 }
 
 template <typename OFF>
+SIMD_TARGET_AVX2
 inline int SetInterCntAVX2DetailTwoFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
     __m256i per_u_order = _mm256_set_epi32(1, 1, 1, 1, 0, 0, 0, 0);
     __m256i per_v_order = _mm256_set_epi32(3, 2, 1, 0, 3, 2, 1, 0);
 
     if (off_nei_u + 1 < uEnd && off_nei_v + 3 < vEnd) {
-        __m256i u_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_u));
+        __m256i u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
         __m256i u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
-        __m256i v_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_v));
+        __m256i v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
         __m256i v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
 
         while (true) {
@@ -229,23 +292,23 @@ inline int SetInterCntAVX2DetailTwoFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OF
                 if (off_nei_u + 1 >= uEnd || off_nei_v + 3 >= vEnd) {
                     break;
                 }
-                u_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_u));
+                u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
                 u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
-                v_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_v));
+                v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
                 v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
             } else if (g->adj[off_nei_u + 1] > g->adj[off_nei_v + 3]) {
                 off_nei_v += 4;
                 if (off_nei_v + 3 >= vEnd) {
                     break;
                 }
-                v_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_v));
+                v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
                 v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
             } else {
                 off_nei_u += 2;
                 if (off_nei_u + 1 >= uEnd) {
                     break;
                 }
-                u_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_u));
+                u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
                 u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
             }
         }
@@ -255,6 +318,7 @@ inline int SetInterCntAVX2DetailTwoFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OF
 
 // The order of off_u and off_v in intersection_res is not important. No duplicated equals.
 template <typename OFF>
+SIMD_TARGET_AVX2
 inline int SetInterCntAVX2Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
     int cnt = 0;
     auto size_ratio = (vEnd - off_nei_v) / (uEnd - off_nei_u);
@@ -269,10 +333,7 @@ inline int SetInterCntAVX2Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_ne
 /*
  * Set Intersection Count End (AVX2) ========================================
  */
-#endif
-
 
-#ifdef __AVX512F__
 
 #ifndef U16_HELPER
 #define U16_HELPER
@@ -282,6 +343,7 @@ inline std::uint16_t operator "" _u(unsigned long long value) {
 #endif
 
 template <typename OFF>
+SIMD_TARGET_AVX512
 inline int SetInterCntAVX512DetailOneSixteen(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
     if (off_nei_u < uEnd && off_nei_v + 15 < vEnd) {
@@ -310,15 +372,16 @@ inline int SetInterCntAVX512DetailOneSixteen(graph_t *g, OFF &off_nei_u, OFF uEn
 }
 
 template <typename OFF>
+SIMD_TARGET_AVX512
 inline int SetInterCntAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd) {
     int cnt = 0;
     __m512i st = _mm512_set_epi32(3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
     __m512i single_permutation = _mm512_set_epi32(3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0);
 
     if (off_nei_u + 3 < uEnd && off_nei_v + 3 < vEnd) {
-        __m512i u_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_u));
+        __m512i u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
         __m512i u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
-        __m512i v_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_v));
+        __m512i v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
         __m512i v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
 
         while (true) {
@@ -329,7 +392,7 @@ inline int SetInterCntAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
                 if (off_nei_v + 3 >= vEnd) {
                     break;
                 }
-                v_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_v));
+                v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
                 v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
 
             } else if (g->adj[off_nei_u + 3] < g->adj[off_nei_v + 3]) {
@@ -337,7 +400,7 @@ inline int SetInterCntAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
                 if (off_nei_u + 3 >= uEnd) {
                     break;
                 }
-                u_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_u));
+                u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
                 u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
             } else {
                 off_nei_u += 4;
@@ -345,9 +408,9 @@ inline int SetInterCntAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
                 if (off_nei_u + 3 >= uEnd || off_nei_v + 3 >= vEnd) {
                     break;
                 }
-                u_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_u));
+                u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
                 u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
-                v_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_v));
+                v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
                 v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
             }
         }
@@ -356,6 +419,7 @@ inline int SetInterCntAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd,
 }
 
 template <typename OFF>
+SIMD_TARGET_AVX512
 inline int SetIntersectionMergeAVX512Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
     int cnt = 0;
     auto size1 = (vEnd - off_nei_v) / (uEnd - off_nei_u);
@@ -368,19 +432,16 @@ inline int SetIntersectionMergeAVX512Detail(graph_t *g, OFF off_nei_u, OFF uEnd,
     return cnt;
 }
 
-#endif
-
-#endif
-
 template <typename OFF>
 inline int SetInterCntVecMerge(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd) {
-    int cn_count = 0;
-#ifdef __AVX2__
-    cn_count = SetInterCntAVX2Detail(g, off_nei_u, uEnd, off_nei_v, vEnd);
-#elif defined(__SSE4_1__)
-    cn_count = SetInterCntSSE4Detail(g, off_nei_u, uEnd, off_nei_v, vEnd);
-#else
-    cn_count = SetIntersectionScalarCntDetail(g, off_nei_u, uEnd, off_nei_v, vEnd);
-#endif
-    return cn_count;
-}
+    switch (GetSIMDKind()) {
+        case SIMD_AVX512:
+            return SetIntersectionMergeAVX512Detail(g, off_nei_u, uEnd, off_nei_v, vEnd);
+        case SIMD_AVX2:
+            return SetInterCntAVX2Detail(g, off_nei_u, uEnd, off_nei_v, vEnd);
+        case SIMD_SSE4:
+            return SetInterCntSSE4Detail(g, off_nei_u, uEnd, off_nei_v, vEnd);
+        default:
+            return SetIntersectionScalarCntDetail(g, off_nei_u, uEnd, off_nei_v, vEnd);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <x86intrin.h>
+
+#include "graph.h"
+#include "set_inter_cnt_utils.h"
+
+/*
+ * Emit Versions of the Set Intersection: same loops as the count versions in set_inter_cnt_utils.h, but write the
+ * offsets of the matches (off_nei_u side and off_nei_v side) into out_off_u and out_off_v, and return the count.
+ */
+
+// Decodes a compare mask, lane l compares u[off_nei_u + (l >> lg_v_lanes)] and v[off_nei_v + (l & (v_lanes - 1))].
+template <typename OFF>
+inline int EmitMatchMask(uint32_t mask, int lg_v_lanes, OFF off_nei_u, OFF off_nei_v,
+                         OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    while (mask != 0) {
+        auto lane = __builtin_ctz(mask);
+        out_off_u[cnt] = off_nei_u + (lane >> lg_v_lanes);
+        out_off_v[cnt] = off_nei_v + (lane & ((1 << lg_v_lanes) - 1));
+        cnt++;
+        mask &= mask - 1;
+    }
+    return cnt;
+}
+
+template <typename OFF>
+inline int SetInterEmitScalarDetail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd,
+                                    OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    if (off_nei_u < uEnd && off_nei_v < vEnd) {
+        while (true) {
+            while (g->adj[off_nei_u] < g->adj[off_nei_v]) {
+                ++off_nei_u;
+                if (off_nei_u >= uEnd) { return cnt; }
+            }
+            while (g->adj[off_nei_u] > g->adj[off_nei_v]) {
+                ++off_nei_v;
+                if (off_nei_v >= vEnd) { return cnt; }
+            }
+            if (g->adj[off_nei_u] == g->adj[off_nei_v]) {
+                out_off_u[cnt] = off_nei_u;
+                out_off_v[cnt] = off_nei_v;
+                ++cnt;
+                ++off_nei_u;
+                ++off_nei_v;
+                if (off_nei_u >= uEnd || off_nei_v >= vEnd) { return cnt; }
+            }
+        }
+    }
+    return cnt;
+}
+
+/*
+ * Set Intersection Emit Begin (SSE4) ========================================
+ */
+template <typename OFF>
+SIMD_TARGET_SSE4
+inline int SetInterEmitSSE4DetailOneFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                         OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    if (off_nei_u < uEnd && off_nei_v + 3 < vEnd) {
+        __m128i u_elements = _mm_set1_epi32(g->adj[off_nei_u]);
+        __m128i v_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_v));
+
+        while (true) {
+            __m128i mask = _mm_cmpeq_epi32(u_elements, v_elements);
+            int real_mask = _mm_movemask_ps((__m128) mask);
+            if (real_mask != 0) {
+                cnt += EmitMatchMask(real_mask, 2, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u] > g->adj[off_nei_v + 3]) {
+                off_nei_v += 4;
+                if (off_nei_v + 3 >= vEnd) {
+                    break;
+                }
+                v_elements = _mm_loadu_si128((__m128i *) (g->adj + off_nei_v));
+            } else {
+                off_nei_u++;
+                if (off_nei_u >= uEnd) {
+                    break;
+                }
+                u_elements = _mm_set1_epi32(g->adj[off_nei_u]);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_SSE4
+inline int SetInterEmitSSE4DetailTwoTwo(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                        OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    constexpr int per_u_order = 0b01010000;
+    constexpr int per_v_order = 0b01000100;
+    if (off_nei_u + 1 < uEnd && off_nei_v + 1 < vEnd) {
+        __m128i u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
+        __m128i u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
+        __m128i v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
+        __m128i v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
+
+        while (true) {
+            __m128i mask = _mm_cmpeq_epi32(u_elements_per, v_elements_per);
+            int real_mask = _mm_movemask_ps((__m128) mask);
+            if (real_mask != 0) {
+                cnt += EmitMatchMask(real_mask, 1, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u + 1] == g->adj[off_nei_v + 1]) {
+                off_nei_u += 2;
+                off_nei_v += 2;
+                if (off_nei_u + 1 >= uEnd || off_nei_v + 1 >= vEnd) {
+                    break;
+                }
+                u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
+                u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
+                v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
+                v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
+            } else if (g->adj[off_nei_u + 1] > g->adj[off_nei_v + 1]) {
+                off_nei_v += 2;
+                if (off_nei_v + 1 >= vEnd) {
+                    break;
+                }
+                v_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_v));
+                v_elements_per = _mm_shuffle_epi32(v_elements, per_v_order);
+            } else {
+                off_nei_u += 2;
+                if (off_nei_u + 1 >= uEnd) {
+                    break;
+                }
+                u_elements = _mm_loadl_epi64((__m128i *) (g->adj + off_nei_u));
+                u_elements_per = _mm_shuffle_epi32(u_elements, per_u_order);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_SSE4
+inline int SetInterEmitSSE4Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd,
+                                  OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    auto size_ratio = (vEnd - off_nei_v) / (uEnd - off_nei_u);
+    if (size_ratio > 2) {
+        cnt += SetInterEmitSSE4DetailOneFour(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    } else {
+        cnt += SetInterEmitSSE4DetailTwoTwo(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    }
+    cnt += SetInterEmitScalarDetail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u + cnt, out_off_v + cnt);
+    return cnt;
+}
+/*
+ * Set Intersection Emit End (SSE4) ========================================
+ */
+
+/*
+ * Set Intersection Emit Begin (AVX2) ========================================
+ */
+template <typename OFF>
+SIMD_TARGET_AVX2
+inline int SetInterEmitAVX2DetailOneEight(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                          OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    if (off_nei_u < uEnd && off_nei_v + 7 < vEnd) {
+        __m256i u_elements = _mm256_set1_epi32(g->adj[off_nei_u]);
+        __m256i v_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_v));
+
+        while (true) {
+            __m256i mask = _mm256_cmpeq_epi32(u_elements, v_elements);
+            auto real_mask = _mm256_movemask_ps((__m256) mask);
+            if (real_mask != 0) {
+                cnt += EmitMatchMask(real_mask, 3, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u] > g->adj[off_nei_v + 7]) {
+                off_nei_v += 8;
+                if (off_nei_v + 7 >= vEnd) {
+                    break;
+                }
+                v_elements = _mm256_loadu_si256((__m256i *) (g->adj + off_nei_v));
+            } else {
+                off_nei_u++;
+                if (off_nei_u >= uEnd) {
+                    break;
+                }
+                u_elements = _mm256_set1_epi32(g->adj[off_nei_u]);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_AVX2
+inline int SetInterEmitAVX2DetailTwoFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                         OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    __m256i per_u_order = _mm256_set_epi32(1, 1, 1, 1, 0, 0, 0, 0);
+    __m256i per_v_order = _mm256_set_epi32(3, 2, 1, 0, 3, 2, 1, 0);
+
+    if (off_nei_u + 1 < uEnd && off_nei_v + 3 < vEnd) {
+        __m256i u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
+        __m256i u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
+        __m256i v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
+        __m256i v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
+
+        while (true) {
+            __m256i mask = _mm256_cmpeq_epi32(u_elements_per, v_elements_per);
+            auto real_mask = _mm256_movemask_ps((__m256) mask);
+            if (real_mask != 0) {
+                cnt += EmitMatchMask(real_mask, 2, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u + 1] == g->adj[off_nei_v + 3]) {
+                off_nei_u += 2;
+                off_nei_v += 4;
+                if (off_nei_u + 1 >= uEnd || off_nei_v + 3 >= vEnd) {
+                    break;
+                }
+                u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
+                u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
+                v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
+                v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
+            } else if (g->adj[off_nei_u + 1] > g->adj[off_nei_v + 3]) {
+                off_nei_v += 4;
+                if (off_nei_v + 3 >= vEnd) {
+                    break;
+                }
+                v_elements = LoadPartialAVX2(g->adj + off_nei_v, 4);
+                v_elements_per = _mm256_permutevar8x32_epi32(v_elements, per_v_order);
+            } else {
+                off_nei_u += 2;
+                if (off_nei_u + 1 >= uEnd) {
+                    break;
+                }
+                u_elements = LoadPartialAVX2(g->adj + off_nei_u, 2);
+                u_elements_per = _mm256_permutevar8x32_epi32(u_elements, per_u_order);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_AVX2
+inline int SetInterEmitAVX2Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd,
+                                  OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    auto size_ratio = (vEnd - off_nei_v) / (uEnd - off_nei_u);
+    if (size_ratio > 2) {
+        cnt += SetInterEmitAVX2DetailOneEight(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    } else {
+        cnt += SetInterEmitAVX2DetailTwoFour(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    }
+    cnt += SetInterEmitScalarDetail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u + cnt, out_off_v + cnt);
+    return cnt;
+}
+/*
+ * Set Intersection Emit End (AVX2) ========================================
+ */
+
+
+template <typename OFF>
+SIMD_TARGET_AVX512
+inline int SetInterEmitAVX512DetailOneSixteen(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                              OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    if (off_nei_u < uEnd && off_nei_v + 15 < vEnd) {
+        __m512i u_elements = _mm512_set1_epi32(g->adj[off_nei_u]);
+        __m512i v_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_v));
+
+        while (true) {
+            __mmask16 mask = _mm512_cmpeq_epi32_mask(u_elements, v_elements);
+            if (mask != 0) {
+                cnt += EmitMatchMask(mask, 4, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u] > g->adj[off_nei_v + 15]) {
+                off_nei_v += 16;
+                if (off_nei_v + 15 >= vEnd) {
+                    break;
+                }
+                v_elements = _mm512_loadu_si512((__m512i *) (g->adj + off_nei_v));
+            } else {
+                off_nei_u++;
+                if (off_nei_u >= uEnd) {
+                    break;
+                }
+                u_elements = _mm512_set1_epi32(g->adj[off_nei_u]);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_AVX512
+inline int SetInterEmitAVX512DetailFourFour(graph_t *g, OFF &off_nei_u, OFF uEnd, OFF &off_nei_v, OFF vEnd,
+                                            OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    __m512i st = _mm512_set_epi32(3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+    __m512i single_permutation = _mm512_set_epi32(3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0, 3, 2, 1, 0);
+
+    if (off_nei_u + 3 < uEnd && off_nei_v + 3 < vEnd) {
+        __m512i u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
+        __m512i u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
+        __m512i v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
+        __m512i v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
+
+        while (true) {
+            __mmask16 mask = _mm512_cmpeq_epi32_mask(u_elements_per, v_elements_per);
+            if (mask != 0) {
+                cnt += EmitMatchMask(mask, 2, off_nei_u, off_nei_v, out_off_u + cnt, out_off_v + cnt);
+            }
+            if (g->adj[off_nei_u + 3] > g->adj[off_nei_v + 3]) {
+                off_nei_v += 4;
+                if (off_nei_v + 3 >= vEnd) {
+                    break;
+                }
+                v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
+                v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
+
+            } else if (g->adj[off_nei_u + 3] < g->adj[off_nei_v + 3]) {
+                off_nei_u += 4;
+                if (off_nei_u + 3 >= uEnd) {
+                    break;
+                }
+                u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
+                u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
+            } else {
+                off_nei_u += 4;
+                off_nei_v += 4;
+                if (off_nei_u + 3 >= uEnd || off_nei_v + 3 >= vEnd) {
+                    break;
+                }
+                u_elements = LoadPartialAVX512(g->adj + off_nei_u, 4);
+                u_elements_per = _mm512_permutexvar_epi32(st, u_elements);
+                v_elements = LoadPartialAVX512(g->adj + off_nei_v, 4);
+                v_elements_per = _mm512_permutexvar_epi32(single_permutation, v_elements);
+            }
+        }
+    }
+    return cnt;
+}
+
+template <typename OFF>
+SIMD_TARGET_AVX512
+inline int SetInterEmitAVX512Detail(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd,
+                                    OFF *out_off_u, OFF *out_off_v) {
+    int cnt = 0;
+    auto size1 = (vEnd - off_nei_v) / (uEnd - off_nei_u);
+    if (size1 > 4) {
+        cnt += SetInterEmitAVX512DetailOneSixteen(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    } else {
+        cnt += SetInterEmitAVX512DetailFourFour(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    }
+    cnt += SetInterEmitScalarDetail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u + cnt, out_off_v + cnt);
+    return cnt;
+}
+
+template <typename OFF>
+inline int SetInterEmitVecMerge(graph_t *g, OFF off_nei_u, OFF uEnd, OFF off_nei_v, OFF vEnd,
+                                OFF *out_off_u, OFF *out_off_v) {
+    switch (GetSIMDKind()) {
+        case SIMD_AVX512:
+            return SetInterEmitAVX512Detail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+        case SIMD_AVX2:
+            return SetInterEmitAVX2Detail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+        case SIMD_SSE4:
+            return SetInterEmitSSE4Detail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+        default:
+            return SetInterEmitScalarDetail(g, off_nei_u, uEnd, off_nei_v, vEnd, out_off_u, out_off_v);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+
+#include "log.h"
+
+/*
+ * Runtime SIMD Dispatch: all kernel variants are compiled into the binary with target attributes
+ * (no -march=native), the variant is chosen at startup with CPUID (or forced, e.g., --simd=avx2).
+ */
+#define SIMD_TARGET_SSE4 __attribute__((target("sse4.1,popcnt")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,popcnt")))
+
+enum simd_kind_t {
+    SIMD_SCALAR = 0, SIMD_SSE4 = 1, SIMD_AVX2 = 2, SIMD_AVX512 = 3
+};
+
+// Constant-initialized, no guard on the hot path, set by InitSIMDKind at startup.
+inline simd_kind_t &SIMDKind() {
+    static simd_kind_t simd_kind = SIMD_SCALAR;
+    return simd_kind;
+}
+
+inline simd_kind_t GetSIMDKind() {
+    return SIMDKind();
+}
+
+inline const char *SIMDKindName(simd_kind_t kind) {
+    static const char *names[] = {"scalar", "sse4", "avx2", "avx512"};
+    return names[kind];
+}
+
+inline simd_kind_t DetectSIMDKind() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt")) {
+        return SIMD_SSE4;
+    }
+    return SIMD_SCALAR;
+}
+
+/*
+ * InitSIMDKind: forced_name in {"", "scalar", "sse4", "avx2", "avx512"}, empty for the CPUID detection.
+ * A forced variant beyond the CPU's support falls back to the detected one.
+ */
+inline simd_kind_t InitSIMDKind(const std::string &forced_name = "") {
+    auto detected = DetectSIMDKind();
+    auto kind = detected;
+    if (!forced_name.empty()) {
+        auto found = false;
+        for (auto it = SIMD_SCALAR; it <= SIMD_AVX512; it = static_cast<simd_kind_t>(it + 1)) {
+            if (forced_name == SIMDKindName(it)) {
+                found = true;
+                kind = it;
+            }
+        }
+        if (!found) {
+            log_warn("Unknown SIMD variant: %s, use the detected one", forced_name.c_str());
+            kind = detected;
+        } else if (kind > detected) {
+            log_warn("SIMD variant %s not supported by the CPU, use %s", forced_name.c_str(), SIMDKindName(detected));
+            kind = detected;
+        }
+    }
+    SIMDKind() = kind;
+    log_info("SIMD variant: %s (detected: %s)", SIMDKindName(kind), SIMDKindName(detected));
+    return kind;
+}
@@ -5,11 +5,13 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
 #include <cstdint>
 
 #include <string>
+#include <algorithm>
 #include <iomanip>
 #include <locale>
 #include <sstream>
@@ -63,4 +65,74 @@ inline int getValue() { //Note: this value is in KB!
     }
     fclose(file);
     return result;
-}
\ No newline at end of file
+}
+
+// Opens file_name for writing (created or truncated), exits on failure: a missing output is not silently skipped.
+inline int OpenFileForWrite(const char *file_name) {
+    auto file_fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (file_fd < 0) {
+        log_fatal("Fail to open %s: %s", file_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return file_fd;
+}
+
+// Closes file_fd, exits on failure (the deferred write errors are reported by close).
+inline void CloseFileForWrite(int file_fd, const char *file_name) {
+    if (close(file_fd) != 0) {
+        log_fatal("Fail to close %s: %s", file_name, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Writes the whole array, exits on failure (a truncated output is not silently kept).
+template<typename T>
+void WriteArrayToFd(int file_fd, const T *arr, size_t size) {
+    auto *chars = reinterpret_cast<const uint8_t *>(arr);
+    size_t total = sizeof(T) * size;
+    for (size_t written = 0; written < total;) {
+        auto ret = write(file_fd, chars + written, total - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            log_fatal("Fail to write fd %d, %zu, %zu: %s", file_fd, written, total,
+                      ret < 0 ? strerror(errno) : "no progress");
+            exit(EXIT_FAILURE);
+        }
+        written += ret;
+    }
+}
+
+template<typename T>
+void WriteArrayToFile(const char *file_name, const T *arr, size_t size) {
+    auto file_fd = OpenFileForWrite(file_name);
+    WriteArrayToFd(file_fd, arr, size);
+    CloseFileForWrite(file_fd, file_name);
+}
+
+// The file as an array of T (malloc, the trailing partial element dropped), size: its length.
+template<typename T>
+T *ReadArrayFromFile(const char *file_name, size_t &size) {
+    size = 0;
+    auto file_fd = open(file_name, O_RDONLY);
+    if (file_fd < 0) {
+        log_error("Fail to open %s", file_name);
+        return nullptr;
+    }
+    size_t total = file_size(file_name) / sizeof(T) * sizeof(T);
+    auto *arr = (T *) malloc(max<size_t>(total, sizeof(T)));
+    auto *chars = reinterpret_cast<uint8_t *>(arr);
+    for (size_t read_size = 0; read_size < total;) {
+        auto ret = pread(file_fd, chars + read_size, total - read_size, read_size);
+        if (ret <= 0) {
+            log_error("Err, %zu, %zu", read_size, total);
+            total = read_size / sizeof(T) * sizeof(T);
+            break;
+        }
+        read_size += ret;
+    }
+    close(file_fd);
+    size = total / sizeof(T);
+    return arr;
+}